@@ -0,0 +1,90 @@
+/**
+ * @file actuators.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Non-blocking LED/buzzer pulses driven by hardware alarms
+ *
+ * Each output owns a slot holding its pending turn-off alarm. A new pulse on
+ * an output that is already on cancels the pending alarm and re-arms it, so
+ * a burst of events keeps the output on until the last pulse expires.
+ */
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "actuators.h"
+
+typedef struct {
+    uint gpio;
+    alarm_id_t alarm;   // Pending turn-off alarm, 0 if none
+    bool used;
+} actuator_slot_t;
+
+static actuator_slot_t slots[ACTUATOR_MAX];
+
+void actuators_init(void) {
+    for (int i = 0; i < ACTUATOR_MAX; i++) {
+        slots[i].used = false;
+        slots[i].alarm = 0;
+    }
+}
+
+static actuator_slot_t *find_slot(uint gpio, bool create) {
+    for (int i = 0; i < ACTUATOR_MAX; i++) {
+        if (slots[i].used && slots[i].gpio == gpio) {
+            return &slots[i];
+        }
+    }
+    if (create) {
+        for (int i = 0; i < ACTUATOR_MAX; i++) {
+            if (!slots[i].used) {
+                slots[i].used = true;
+                slots[i].gpio = gpio;
+                slots[i].alarm = 0;
+                return &slots[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+// === Alarm callback (IRQ context): switch the output off ===
+static int64_t turn_off_callback(alarm_id_t id, void *user_data) {
+    actuator_slot_t *slot = (actuator_slot_t *)user_data;
+    if (slot->alarm == id) {
+        gpio_put(slot->gpio, 0);
+        slot->alarm = 0;
+    }
+    return 0;  // One-shot
+}
+
+// === Switch an output on for duration_ms without blocking ===
+bool actuator_pulse(uint gpio, uint32_t duration_ms) {
+    actuator_slot_t *slot = find_slot(gpio, true);
+    if (slot == NULL) {
+        printf("WARNING: No actuator slot for GPIO %u\n", gpio);
+        return false;
+    }
+
+    // Keep the alarm IRQ out while the slot is being re-armed
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (slot->alarm > 0) {
+        cancel_alarm(slot->alarm);
+        slot->alarm = 0;
+    }
+    gpio_put(gpio, 1);
+    alarm_id_t alarm = add_alarm_in_ms(duration_ms, turn_off_callback, slot, false);
+    if (alarm > 0) {
+        slot->alarm = alarm;
+    } else {
+        gpio_put(gpio, 0);  // Alarm pool exhausted: never leave the output stuck on
+    }
+    restore_interrupts(irq_state);
+
+    return alarm > 0;
+}
+
+bool actuator_is_active(uint gpio) {
+    actuator_slot_t *slot = find_slot(gpio, false);
+    return slot != NULL && slot->alarm > 0;
+}
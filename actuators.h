@@ -0,0 +1,28 @@
+/**
+ * @file actuators.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Non-blocking LED/buzzer pulses driven by hardware alarms
+ *
+ * actuator_pulse() switches an output on and schedules its turn-off on the
+ * default alarm pool, so the caller returns immediately instead of sleeping
+ * for the whole pulse.
+ */
+
+#ifndef ACTUATORS_H
+#define ACTUATORS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/types.h"
+
+// Maximum number of outputs that can be pulsed at the same time
+#ifndef ACTUATOR_MAX
+#define ACTUATOR_MAX    4
+#endif
+
+void actuators_init(void);
+bool actuator_pulse(uint gpio, uint32_t duration_ms);
+bool actuator_is_active(uint gpio);
+
+#endif // ACTUATORS_H
@@ -0,0 +1,137 @@
+/**
+ * @file button_capture.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Interrupt-driven button edge capture with microsecond timestamps
+ *
+ * Buttons are active low with pull-ups. Each ring entry holds the GPIO (id),
+ * the level right after the edge (payload: 1 = pressed) and its timestamp.
+ * Storing the level rather than the edge type keeps the stream correct even
+ * when a rise and a fall are latched by a single interrupt.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "event_queue.h"
+#include "button_capture.h"
+
+typedef struct {
+    uint gpio;
+    bool pressed;           // Debounced state
+    uint64_t last_change_us;  // Time of the last accepted transition
+    uint64_t last_edge_us;    // Time of the last edge of any kind
+} button_state_t;
+
+static event_queue_t edge_ring;     // ISR -> button_capture_next()
+static button_state_t buttons[BUTTON_CAPTURE_MAX];
+static uint button_count = 0;
+static uint32_t debounce_window_us = 0;
+static uint32_t bounce_count = 0;
+
+static button_state_t *find_button(uint gpio) {
+    for (uint i = 0; i < button_count; i++) {
+        if (buttons[i].gpio == gpio) {
+            return &buttons[i];
+        }
+    }
+    return NULL;
+}
+
+// === GPIO ISR: timestamp the edge and get out ===
+static void __not_in_flash_func(button_edge_isr)(uint gpio, uint32_t events) {
+    (void)events;
+    event_t edge = {
+        .timestamp_us = time_us_64(),
+        .payload = gpio_get(gpio) ? 0 : 1,  // Active low
+        .id = (uint8_t)gpio,
+    };
+    event_queue_push(&edge_ring, &edge);
+}
+
+// === Enable edge interrupts on the given (already configured) inputs ===
+bool button_capture_init(const uint *gpios, uint count, uint32_t debounce_us) {
+    if (count > BUTTON_CAPTURE_MAX) {
+        return false;
+    }
+
+    event_queue_init(&edge_ring);
+    debounce_window_us = debounce_us;
+    button_count = count;
+
+    for (uint i = 0; i < count; i++) {
+        buttons[i].gpio = gpios[i];
+        buttons[i].pressed = !gpio_get(gpios[i]);
+        buttons[i].last_change_us = buttons[i].last_edge_us = time_us_64();
+    }
+    for (uint i = 0; i < count; i++) {
+        gpio_set_irq_enabled_with_callback(gpios[i], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE,
+                                           true, button_edge_isr);
+    }
+    return true;
+}
+
+// === Apply one transition to the debounced state; true on a new press ===
+static bool apply_level(button_state_t *button, bool pressed, uint64_t timestamp_us,
+                        button_press_t *press) {
+    if (pressed == button->pressed) {
+        return false;
+    }
+    button->pressed = pressed;
+    button->last_change_us = timestamp_us;
+    if (!pressed) {
+        return false;
+    }
+    press->gpio = button->gpio;
+    press->timestamp_us = timestamp_us;
+    return true;
+}
+
+// === Debounce the edge stream; returns true for each accepted press ===
+bool button_capture_next(button_press_t *press) {
+    event_t edge;
+
+    while (event_queue_pop(&edge_ring, &edge)) {
+        button_state_t *button = find_button(edge.id);
+        if (button == NULL) {
+            continue;
+        }
+        button->last_edge_us = edge.timestamp_us;
+
+        // Edges inside the window after an accepted transition are bounce
+        if (edge.timestamp_us - button->last_change_us < debounce_window_us) {
+            bounce_count++;
+            continue;
+        }
+        if (apply_level(button, edge.payload != 0, edge.timestamp_us, press)) {
+            return true;
+        }
+    }
+
+    // A level that settled while its edges were rejected as bounce: adopt it
+    // once the line has been quiet for a full window (e.g. a short tap).
+    uint64_t now = time_us_64();
+    for (uint i = 0; i < button_count; i++) {
+        button_state_t *button = &buttons[i];
+        if (now - button->last_edge_us < debounce_window_us) {
+            continue;
+        }
+        bool level = !gpio_get(button->gpio);
+        if (apply_level(button, level, button->last_edge_us, press)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool button_capture_is_pressed(uint gpio) {
+    button_state_t *button = find_button(gpio);
+    return button != NULL && button->pressed;
+}
+
+void button_capture_get_stats(button_capture_stats_t *stats) {
+    stats->edges = edge_ring.head + edge_ring.overflows;
+    stats->bounces = bounce_count;
+    stats->overflows = edge_ring.overflows;
+    stats->high_water = edge_ring.high_water;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file button_capture.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Interrupt-driven button edge capture with microsecond timestamps
+ *
+ * The GPIO ISR only timestamps each edge with time_us_64() and pushes it into
+ * a lock-free ring. Debouncing happens later, in button_capture_next(), by
+ * time-windowing that edge stream. Accepted presses keep the timestamp of
+ * the first edge of the press, not the time they were processed.
+ */
+
+#ifndef BUTTON_CAPTURE_H
+#define BUTTON_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/types.h"
+
+// Maximum number of buttons handled
+#define BUTTON_CAPTURE_MAX  2
+
+typedef struct {
+    uint gpio;              // Button GPIO
+    uint64_t timestamp_us;  // Time of the edge that started the press
+} button_press_t;
+
+typedef struct {
+    uint32_t edges;         // Edges captured by the ISR
+    uint32_t bounces;       // Edges rejected by the debounce window
+    uint32_t overflows;     // Edges lost because the ring was full
+    uint32_t high_water;    // Maximum ring depth
+} button_capture_stats_t;
+
+bool button_capture_init(const uint *gpios, uint count, uint32_t debounce_us);
+bool button_capture_next(button_press_t *press);
+bool button_capture_is_pressed(uint gpio);
+void button_capture_get_stats(button_capture_stats_t *stats);
+
+#endif // BUTTON_CAPTURE_H
@@ -0,0 +1,88 @@
+/**
+ * @file event_queue.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Lock-free single-producer/single-consumer event queue
+ */
+
+#include <string.h>
+#include "hardware/sync.h"
+#include "event_queue.h"
+
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_CAPACITY - 1)
+
+// Names written to the log file (CSV "Event" column)
+static const char *const event_names[EVENT_COUNT] = {
+    [EVENT_NONE]             = "NONE",
+    [EVENT_BUTTON_A_PRESSED] = "BUTTON_A_PRESSED",
+    [EVENT_BUTTON_B_PRESSED] = "BUTTON_B_PRESSED",
+    [EVENT_BUZZER_ACTIVATED] = "BUZZER_ACTIVATED",
+    [EVENT_JOYSTICK_MOVED]   = "JOYSTICK_MOVED",
+    [EVENT_JOYSTICK_POS]     = "JOYSTICK_POS",
+};
+
+// Text shown on the OLED
+static const char *const event_texts[EVENT_COUNT] = {
+    [EVENT_NONE]             = "",
+    [EVENT_BUTTON_A_PRESSED] = "BUTTON_A_PRESSED",
+    [EVENT_BUTTON_B_PRESSED] = "BUTTON_B_PRESSED",
+    [EVENT_BUZZER_ACTIVATED] = "BUZZER ACTIVATED",
+    [EVENT_JOYSTICK_MOVED]   = "JOYSTICK_MOVED",
+    [EVENT_JOYSTICK_POS]     = "",
+};
+
+void event_queue_init(event_queue_t *queue) {
+    memset(queue, 0, sizeof(*queue));
+}
+
+// === Producer side ===
+bool event_queue_push(event_queue_t *queue, const event_t *event) {
+    uint32_t head = queue->head;
+    uint32_t depth = head - queue->tail;
+
+    if (depth >= EVENT_QUEUE_CAPACITY) {
+        queue->overflows++;
+        return false;
+    }
+
+    queue->slots[head & EVENT_QUEUE_MASK] = *event;
+    __dmb();  // Slot contents must be visible before the new head
+    queue->head = head + 1;
+
+    if (depth + 1 > queue->high_water) {
+        queue->high_water = depth + 1;
+    }
+    return true;
+}
+
+// === Consumer side ===
+bool event_queue_pop(event_queue_t *queue, event_t *event) {
+    uint32_t tail = queue->tail;
+
+    if (queue->head == tail) {
+        return false;
+    }
+
+    __dmb();  // Read the slot only after observing the producer's head
+    *event = queue->slots[tail & EVENT_QUEUE_MASK];
+    __dmb();  // Finish reading before handing the slot back
+    queue->tail = tail + 1;
+    return true;
+}
+
+uint32_t event_queue_count(const event_queue_t *queue) {
+    return queue->head - queue->tail;
+}
+
+const char *event_name(uint8_t id) {
+    return (id < EVENT_COUNT) ? event_names[id] : "UNKNOWN";
+}
+
+const char *event_display_text(uint8_t id) {
+    return (id < EVENT_COUNT) ? event_texts[id] : "UNKNOWN";
+}
+
+// Periodic samples are logged but not echoed to the console or the OLED
+bool event_is_sample(uint8_t id) {
+    return id == EVENT_JOYSTICK_POS;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file event_queue.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Lock-free single-producer/single-consumer event queue
+ *
+ * The sampling path pushes timestamped events; the sink (SD log + OLED)
+ * pops them. Only the producer writes `head` and only the consumer writes
+ * `tail`, so no lock is needed as long as each side stays on one context.
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// === Build-time Configuration ===
+// Number of slots. Must be a power of two.
+#ifndef EVENT_QUEUE_CAPACITY
+#define EVENT_QUEUE_CAPACITY    64
+#endif
+
+#if (EVENT_QUEUE_CAPACITY & (EVENT_QUEUE_CAPACITY - 1)) != 0
+#error "EVENT_QUEUE_CAPACITY must be a power of two"
+#endif
+
+// === Event Identifiers ===
+typedef enum {
+    EVENT_NONE = 0,
+    EVENT_BUTTON_A_PRESSED,
+    EVENT_BUTTON_B_PRESSED,
+    EVENT_BUZZER_ACTIVATED,
+    EVENT_JOYSTICK_MOVED,
+    EVENT_JOYSTICK_POS,     // Periodic position sample, payload = x | y << 12
+    EVENT_COUNT
+} event_id_t;
+
+// === Event Record ===
+typedef struct {
+    uint64_t timestamp_us;  // Time of detection, microseconds since boot
+    uint32_t payload;       // Event-specific value
+    uint8_t id;             // event_id_t
+} event_t;
+
+// === Queue ===
+typedef struct {
+    event_t slots[EVENT_QUEUE_CAPACITY];
+    volatile uint32_t head;         // Next slot to write (producer only)
+    volatile uint32_t tail;         // Next slot to read (consumer only)
+    volatile uint32_t overflows;    // Events dropped because the queue was full
+    volatile uint32_t high_water;   // Maximum depth observed by the producer
+} event_queue_t;
+
+void event_queue_init(event_queue_t *queue);
+bool event_queue_push(event_queue_t *queue, const event_t *event);
+bool event_queue_pop(event_queue_t *queue, event_t *event);
+uint32_t event_queue_count(const event_queue_t *queue);
+
+const char *event_name(uint8_t id);
+const char *event_display_text(uint8_t id);
+bool event_is_sample(uint8_t id);
+
+#endif // EVENT_QUEUE_H
@@ -34,8 +34,9 @@ static spi_t spis[] = {
         .miso_gpio = 16,      // GPIO para MISO (entrada de dados)
         .mosi_gpio = 19,      // GPIO para MOSI (saída de dados)
         .sck_gpio = 18,       // GPIO para clock SPI
-        .baud_rate = 1000000  // Taxa de transmissão: 1 Mbps
-        // Alternativa comentada: 25 Mbps (frequência real: ~20.8 MHz)
+        .baud_rate = 25000000 // Teto do clock SPI: 25 MHz (real: ~20.8 MHz)
+        // O driver sobe o clock em degraus até o menor valor entre este teto
+        // e o TRAN_SPEED do cartão, verificando cada degrau
     }
 };
 
@@ -3,11 +3,34 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdbool.h>
 #include "math.h"
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
-
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+
+// Dois quadros: o de trás (SSD1306_Buffer) recebe o desenho; o da frente é o
+// último apresentado, o que está (ou está indo) para a RAM do display, e nunca
+// é alterado pelo desenho. ssd1306_Present() troca os ponteiros.
+//
+// Atualização parcial: Present compara os dois quadros página a página e envia
+// só as colunas alteradas, numa janela de endereçamento (0x21/0x22). Páginas
+// vizinhas alteradas são juntadas numa só janela quando isso custa menos bytes
+// que duas janelas.
+#define SSD1306_PAGES           (SSD1306_HEIGHT / 8)
+#define SSD1306_COL_OFFSET      ((SSD1306_X_OFFSET_UPPER << 4) | SSD1306_X_OFFSET_LOWER)
+#define SSD1306_WINDOW_WORDS    13  // 6 comandos, cada um com seu byte de controle 0x80, mais o controle 0x40
+#define SSD1306_WINDOW_COST     (SSD1306_WINDOW_WORDS + 1)  // Mais o byte de endereço I2C
+#define SSD1306_TX_WORDS        (SSD1306_BUFFER_SIZE + SSD1306_PAGES * SSD1306_WINDOW_WORDS)
+
+static uint8_t SSD1306_Frames[2][SSD1306_BUFFER_SIZE];
+static uint8_t *SSD1306_Buffer = SSD1306_Frames[0]; // Quadro de trás: onde se desenha
+static uint8_t *SSD1306_Front = SSD1306_Frames[1];  // Quadro da frente: o que o display mostra
+static bool SSD1306_FrontValid = false;     // false: o próximo Present envia a tela toda
+static SSD1306_Stats_t SSD1306_Stats;
 
 #if defined(SSD1306_USE_I2C) //Verifica se o protocolo I2C está habilitado.
 
@@ -15,22 +38,121 @@
 const uint8_t I2C_SDA_PIN_OLED = 14;
 const uint8_t I2C_SCL_PIN_OLED = 15;
 
+// Envio por DMA: o quadro inteiro (todas as janelas) vai numa só transferência
+// para o registrador IC_DATA_CMD. Cada palavra de 16 bits leva um byte e, no
+// último byte de cada janela, o bit STOP; o próximo byte abre outra transação.
+// A CPU fica livre enquanto o I2C envia. O fim é detectado pela interrupção
+// STOP_DET do I2C (não pela do DMA): quando o DMA termina, ainda há até 16
+// bytes na FIFO do I2C.
+static uint16_t SSD1306_TxWords[SSD1306_TX_WORDS];
+static size_t SSD1306_TxLen;
+static int SSD1306_DmaChan = -1;
+static volatile bool SSD1306_Flushing = false;
+static SSD1306_Callback_t SSD1306_FlushCallback;
+static void *SSD1306_FlushCtx;
+
+static void ssd1306_I2cIrq(void) {
+    i2c_hw_t *hw = i2c_get_hw(SSD1306_I2C_PORT);
+    uint32_t stat = hw->intr_stat;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // NACK ou perda de barramento: o I2C descarta a FIFO; pára o DMA
+        dma_channel_abort(SSD1306_DmaChan);
+        (void)hw->clr_tx_abrt;
+        SSD1306_Stats.errors++;
+        SSD1306_FrontValid = false;     // O display pode ter ficado com parte do quadro
+    } else if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        if (dma_channel_is_busy(SSD1306_DmaChan) || hw->txflr != 0) {
+            return;                     // Fim de uma janela intermediária
+        }
+    } else {
+        return;
+    }
+
+    hw->intr_mask = 0;
+    SSD1306_Flushing = false;
+    if (SSD1306_FlushCallback) {
+        SSD1306_FlushCallback(SSD1306_FlushCtx);
+    }
+}
+
+// Reserva o canal DMA (ritmado pelo DREQ de TX do I2C) e a interrupção do I2C
+static void ssd1306_SetupDma(void) {
+    i2c_hw_t *hw = i2c_get_hw(SSD1306_I2C_PORT);
+    hw->intr_mask = 0;                  // Só STOP_DET/TX_ABRT, e só durante um envio
+
+    if (SSD1306_DmaChan < 0) {
+        SSD1306_DmaChan = dma_claim_unused_channel(true);
+        uint irq = I2C0_IRQ + i2c_hw_index(SSD1306_I2C_PORT);
+        irq_set_exclusive_handler(irq, ssd1306_I2cIrq);
+        irq_set_enabled(irq, true);
+    }
+
+    dma_channel_config cfg = dma_channel_get_default_config(SSD1306_DmaChan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, i2c_get_dreq(SSD1306_I2C_PORT, true));
+    dma_channel_configure(SSD1306_DmaChan, &cfg, &hw->data_cmd, SSD1306_TxWords, 0, false);
+}
+
+// Inicia o envio de SSD1306_TxWords[0..SSD1306_TxLen)
+static void ssd1306_StartTx(SSD1306_Callback_t callback, void *ctx) {
+    i2c_hw_t *hw = i2c_get_hw(SSD1306_I2C_PORT);
+    hw->enable = 0;                     // O endereço só pode mudar com o I2C desligado
+    hw->tar = SSD1306_I2C_ADDR;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+
+    SSD1306_FlushCallback = callback;
+    SSD1306_FlushCtx = ctx;
+    SSD1306_Flushing = true;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    dma_channel_transfer_from_buffer_now(SSD1306_DmaChan, SSD1306_TxWords, SSD1306_TxLen);
+}
+
+/**
+ * @brief Indica se um envio para o display ainda está em andamento.
+ */
+bool ssd1306_FlushBusy(void) {
+    return SSD1306_Flushing;
+}
+
+/**
+ * @brief Espera o fim do envio em andamento (retorna logo se não houver).
+ */
+void ssd1306_WaitFlush(void) {
+    while (SSD1306_Flushing) {
+        tight_loop_contents();
+    }
+}
+
 // Enviar um byte para o registrador de comando
 void ssd1306_WriteCommand(uint8_t byte) {
     uint8_t buffer[2];           // Buffer contendo o registrador e o dado (Cria um buffer de 2 bytes.)
     buffer[0] = 0x00;            // Endereço do registrador, define o byte de controle como 0x00 (indica que é um comando).
     buffer[1] = byte;            // Armazena o comando a ser enviado. Dado a ser enviado 
 
+    ssd1306_WaitFlush();         // Não intercala com um quadro sendo enviado por DMA
     i2c_write_blocking(SSD1306_I2C_PORT, SSD1306_I2C_ADDR, buffer, sizeof(buffer), false); // Envia o buffer via I2C para o endereço do display.
 }
 
-// Enviar dados
+// Enviar dados (bloqueante, pelo mesmo caminho de DMA dos quadros)
 void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
-    uint8_t temp_buffer[buff_size + 1]; // Cria um buffer temporário com espaço para o byte de controle e os dados.
-    temp_buffer[0] = 0x40;             // Define o byte de controle como 0x40 (indica que são dados).
-    memcpy(&temp_buffer[1], buffer, buff_size); // Copia os dados para o buffer temporário
-
-    i2c_write_blocking(SSD1306_I2C_PORT, SSD1306_I2C_ADDR, temp_buffer, sizeof(temp_buffer), false); // Envia o buffer via I2C.
+    if (buff_size == 0 || buff_size >= SSD1306_TX_WORDS) {
+        return;
+    }
+    ssd1306_WaitFlush();
+    SSD1306_TxWords[0] = 0x40;         // Byte de controle 0x40 (indica que são dados)
+    for (size_t i = 0; i < buff_size; i++) {
+        SSD1306_TxWords[i + 1] = buffer[i];
+    }
+    SSD1306_TxWords[buff_size] |= I2C_IC_DATA_CMD_STOP_BITS;
+    SSD1306_TxLen = buff_size + 1;
+    ssd1306_StartTx(NULL, NULL);
+    ssd1306_WaitFlush();
 }
 
 #else
@@ -38,8 +160,6 @@ void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
 #endif
 
 
-static uint8_t SSD1306_Buffer[SSD1306_BUFFER_SIZE]; //Cria um buffer para armazenar o estado de cada pixel (1 bit por pixel). De tam.: 1024 bytes.
-
 // Objeto display
 static SSD1306_t SSD1306;
 
@@ -64,6 +184,7 @@ void ssd1306_Init(void) {
     // Habilita pull-ups
     gpio_pull_up(I2C_SDA_PIN_OLED);
     gpio_pull_up(I2C_SCL_PIN_OLED);
+    ssd1306_SetupDma();                 // Canal DMA e interrupção do I2C para os quadros
 
     // Inicializa o display 
     ssd1306_SetDisplayOn(0); // Desliga o display temporariamente
@@ -151,7 +272,11 @@ void ssd1306_Init(void) {
 
     // Clear screen
     ssd1306_Fill(Black);
-    
+
+    // A RAM do display tem conteúdo desconhecido (ou de um Init anterior):
+    // o primeiro quadro vai inteiro, sem comparar com a cópia
+    ssd1306_Invalidate();
+
     // Flush buffer to screen
     ssd1306_UpdateScreen();
     
@@ -164,23 +289,147 @@ void ssd1306_Init(void) {
 
 /* Fill the whole screen with the given color */
 void ssd1306_Fill(SSD1306_COLOR color) {
-    memset(SSD1306_Buffer, (color == Black) ? 0x00 : 0xFF, sizeof(SSD1306_Buffer)); //Preenche o buffer de tela com 0x00 (preto) ou 0xFF (branco), dependendo da cor especificada.
+    memset(SSD1306_Buffer, (color == Black) ? 0x00 : 0xFF, SSD1306_BUFFER_SIZE); //Preenche o buffer de tela com 0x00 (preto) ou 0xFF (branco), dependendo da cor especificada.
 }
 
-/* Write the screenbuffer with changed to the screen */
-void ssd1306_UpdateScreen(void) {
-    // Write data to each page of RAM. Number of pages
-    // depends on the screen height:
+/* Põe na fila de envio as páginas p0..p1, colunas c0..c1, numa janela; retorna os bytes */
+static uint32_t ssd1306_QueueWindow(uint8_t p0, uint8_t p1, uint8_t c0, uint8_t c1) {
+    const uint8_t window[] = {
+        0x21, c0 + SSD1306_COL_OFFSET, c1 + SSD1306_COL_OFFSET, // Coluna inicial e final
+        0x22, p0, p1                                            // Página inicial e final
+    };
+    // Comandos e dados numa só transação: 0x80 (Co=1) antes de cada comando,
+    // depois 0x40 (Co=0, D/C=1) e o resto da transação são dados
+    uint16_t *w = &SSD1306_TxWords[SSD1306_TxLen];
+    for (size_t i = 0; i < sizeof(window); i++) {
+        *w++ = 0x80;
+        *w++ = window[i];
+    }
+    *w++ = 0x40;
+
+    // No modo horizontal o display percorre a janela linha a linha (página a página)
+    for (uint8_t p = p0; p <= p1; p++) {
+        const uint8_t *src = &SSD1306_Front[p * SSD1306_WIDTH];
+        for (uint8_t c = c0; c <= c1; c++) {
+            *w++ = src[c];
+        }
+    }
+    w[-1] |= I2C_IC_DATA_CMD_STOP_BITS; // Fim da transação desta janela
+
+    uint32_t bytes = w - &SSD1306_TxWords[SSD1306_TxLen];
+    SSD1306_TxLen += bytes;
+    SSD1306_Stats.windows++;
+    return bytes;
+}
+
+/**
+ * @brief Apresenta o quadro desenhado: troca frente/trás e inicia o envio, sem esperar.
+ *
+ * O quadro completo passa a ser o da frente e só as alterações em relação ao
+ * anterior vão ao display. O novo quadro de trás já sai igual ao apresentado,
+ * então o próximo quadro pode ser desenhado (por cima ou do zero) enquanto o
+ * DMA envia este.
+ * @param callback Chamada (no contexto da interrupção do I2C) ao fim do envio; pode ser NULL.
+ * @param ctx Argumento repassado ao callback.
+ * @return false se o envio anterior ainda não terminou (nada é perdido: as
+ *         alterações vão no próximo quadro); true se começou ou não havia nada a enviar.
+ */
+bool ssd1306_Present(SSD1306_Callback_t callback, void *ctx) {
+    if (SSD1306_Flushing) {
+        return false;
+    }
+
+    // Faixa de colunas alterada em cada página (first > last: página intacta).
+    // Number of pages depends on the screen height:
     //
     //  * 32px   ==  4 pages
     //  * 64px   ==  8 pages
     //  * 128px  ==  16 pages
-    for(uint8_t i = 0; i < SSD1306_HEIGHT/8; i++) {  //Itera sobre cada página (bloco de 8 pixels de altura).
-        ssd1306_WriteCommand(0xB0 + i); // Define a página atual. (RAM page address).
-        ssd1306_WriteCommand(0x00 + SSD1306_X_OFFSET_LOWER); // Define a coluna inicial.
-        ssd1306_WriteCommand(0x10 + SSD1306_X_OFFSET_UPPER); // Define a coluna final.
-        ssd1306_WriteData(&SSD1306_Buffer[SSD1306_WIDTH*i],SSD1306_WIDTH); //Envia os dados da página atual para o display.
+    int16_t first[SSD1306_PAGES], last[SSD1306_PAGES];
+    for (uint8_t p = 0; p < SSD1306_PAGES; p++) {
+        const uint8_t *buf = &SSD1306_Buffer[p * SSD1306_WIDTH];
+        const uint8_t *front = &SSD1306_Front[p * SSD1306_WIDTH];
+        first[p] = 0;
+        last[p] = SSD1306_WIDTH - 1;
+        if (SSD1306_FrontValid) {
+            while (first[p] < SSD1306_WIDTH && buf[first[p]] == front[first[p]]) first[p]++;
+            while (last[p] >= first[p] && buf[last[p]] == front[last[p]]) last[p]--;
+        }
+    }
+
+    uint8_t *presented = SSD1306_Buffer;
+    SSD1306_Buffer = SSD1306_Front;
+    SSD1306_Front = presented;
+    SSD1306_FrontValid = true;
+
+    uint32_t bytes = 0;
+    SSD1306_TxLen = 0;
+    for (uint8_t p = 0; p < SSD1306_PAGES; p++) {
+        if (first[p] > last[p]) {
+            continue;
+        }
+        uint8_t p0 = p;
+        int16_t c0 = first[p], c1 = last[p];
+        // Junta a próxima página se a janela maior custar menos que uma nova janela
+        while (p + 1 < SSD1306_PAGES && first[p + 1] <= last[p + 1]) {
+            int16_t n0 = (first[p + 1] < c0) ? first[p + 1] : c0;
+            int16_t n1 = (last[p + 1] > c1) ? last[p + 1] : c1;
+            uint32_t merged = (p + 2 - p0) * (n1 - n0 + 1);
+            uint32_t separate = (p + 1 - p0) * (c1 - c0 + 1) + SSD1306_WINDOW_COST +
+                                (last[p + 1] - first[p + 1] + 1);
+            if (merged > separate) {
+                break;
+            }
+            c0 = n0;
+            c1 = n1;
+            p++;
+        }
+        bytes += ssd1306_QueueWindow(p0, p, c0, c1);
     }
+
+    // O quadro de trás é o anterior: basta copiar as faixas que mudaram
+    for (uint8_t p = 0; p < SSD1306_PAGES; p++) {
+        if (first[p] <= last[p]) {
+            size_t at = p * SSD1306_WIDTH + first[p];
+            memcpy(&SSD1306_Buffer[at], &SSD1306_Front[at], last[p] - first[p] + 1);
+        }
+    }
+
+    if (bytes == 0) {
+        SSD1306_Stats.skipped++;
+        if (callback) {
+            callback(ctx);
+        }
+        return true;
+    }
+    SSD1306_Stats.frames++;
+    SSD1306_Stats.last_bytes = bytes;
+    SSD1306_Stats.total_bytes += bytes;
+    ssd1306_StartTx(callback, ctx);
+    return true;
+}
+
+/* Write the screenbuffer with changed to the screen */
+void ssd1306_UpdateScreen(void) {
+    ssd1306_WaitFlush();
+    ssd1306_Present(NULL, NULL);
+    ssd1306_WaitFlush();
+}
+
+/**
+ * @brief Força o envio da tela inteira no próximo ssd1306_UpdateScreen().
+ * @note Necessário quando a RAM do display muda por fora do buffer (ex.: scroll).
+ */
+void ssd1306_Invalidate(void) {
+    SSD1306_FrontValid = false;
+}
+
+/**
+ * @brief Copia os contadores de bytes enviados por quadro.
+ * @param stats Destino dos contadores.
+ */
+void ssd1306_GetStats(SSD1306_Stats_t *stats) {
+    *stats = SSD1306_Stats;
 }
 
 /*
@@ -203,6 +452,40 @@ void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color) {
     }
 }
 
+/*
+ * Copia um glifo em formato de página (1 byte = 8 linhas de uma coluna) para o
+ * buffer no cursor. Cada faixa de 8 linhas vira um ou dois bytes por coluna
+ * (dois quando Y não é múltiplo de 8), gravados com máscara: a célula do
+ * glifo é opaca, como no desenho pixel a pixel. Os limites já foram checados.
+ */
+static void ssd1306_BlitGlyph(const uint8_t *cols, uint8_t width, uint8_t height, SSD1306_COLOR color) {
+    uint8_t shift = SSD1306.CurrentY % 8;
+    uint8_t *dst = &SSD1306_Buffer[(SSD1306.CurrentY / 8) * SSD1306_WIDTH + SSD1306.CurrentX];
+
+    for (uint8_t row = 0; row < height; row += 8, dst += SSD1306_WIDTH, cols += width) {
+        uint8_t mask = (height - row >= 8) ? 0xFF : (uint8_t)((1u << (height - row)) - 1);
+        uint8_t invert = (color == White) ? 0x00 : mask;
+
+        if (shift == 0 && mask == 0xFF) {
+            // Faixa alinhada e cheia: bytes inteiros
+            for (uint8_t x = 0; x < width; x++) {
+                dst[x] = cols[x] ^ invert;
+            }
+            continue;
+        }
+
+        uint8_t lo_mask = (uint8_t)(mask << shift);
+        uint8_t hi_mask = (uint8_t)(mask >> (8 - shift)); // 0 se shift == 0
+        for (uint8_t x = 0; x < width; x++) {
+            uint8_t bits = cols[x] ^ invert;
+            dst[x] = (dst[x] & ~lo_mask) | (uint8_t)(bits << shift);
+            if (hi_mask) {
+                dst[x + SSD1306_WIDTH] = (dst[x + SSD1306_WIDTH] & ~hi_mask) | (bits >> (8 - shift));
+            }
+        }
+    }
+}
+
 /*
  * Draw 1 char to the screen buffer
  * ch       => char om weg te schrijven
@@ -224,7 +507,20 @@ char ssd1306_WriteChar(char ch, SSD1306_Font_t Font, SSD1306_COLOR color) {
         return 0;
     }
     
-    // Use the font to write
+    if (Font.columns) {
+        uint8_t glyph = Font.glyph_map ? Font.glyph_map[ch - 32] : (uint8_t)(ch - 32);
+        if (glyph == 0xFF) {
+            // Left out of this build (OLED_FONT_CHARS)
+            return 0;
+        }
+        ssd1306_BlitGlyph(&Font.columns[glyph * ((Font.height + 7) / 8) * Font.width],
+                          Font.width, Font.height, color);
+        SSD1306.CurrentX += Font.char_width ? Font.char_width[ch - 32] : Font.width;
+        return ch;
+    }
+
+    // Fonte sem colunas (escrita à mão, ou a referência de tools/glyph_check.c):
+    // desenha pixel a pixel a partir das linhas. As fontes geradas não passam aqui
     for(i = 0; i < Font.height; i++) {
         b = Font.data[(ch - 32) * Font.height + i];
         for(j = 0; j < Font.width; j++) {
@@ -624,6 +920,7 @@ void ssd1306_StartScrollLeft(uint8_t startPage, uint8_t endPage, uint8_t scrollS
  */
 void ssd1306_StopScroll(void) {
     ssd1306_WriteCommand(0x2E); // Desativa o scroll
+    ssd1306_Invalidate();       // O scroll deslocou a RAM do display; reenviar tudo
 }
 
 /**
@@ -3,6 +3,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <_ansi.h>
 
 _BEGIN_STD_C
@@ -56,6 +57,19 @@ typedef enum {
     SSD1306_ERR = 0x01  // Generic error.
 } SSD1306_Error_t;
 
+// Contadores de ssd1306_UpdateScreen() (bytes I2C sem o byte de endereço)
+typedef struct {
+    uint32_t frames;        // Chamadas com alguma alteração enviada
+    uint32_t skipped;       // Chamadas sem nada alterado
+    uint32_t windows;       // Janelas (páginas x colunas) enviadas
+    uint32_t last_bytes;    // Bytes do último quadro enviado
+    uint32_t total_bytes;   // Bytes de todos os quadros
+    uint32_t errors;        // Envios abortados (NACK ou perda de barramento)
+} SSD1306_Stats_t;
+
+// Chamada ao fim de um envio assíncrono (no contexto da interrupção do I2C)
+typedef void (*SSD1306_Callback_t)(void *ctx);
+
 // Struct to store transformations
 typedef struct {
     uint16_t CurrentX;
@@ -69,12 +83,20 @@ typedef struct {
     uint8_t y;
 } SSD1306_VERTEX;
 
-/** Font */
+/** Font
+ *
+ * The firmware's fonts come from tools/font_columns.py and always have
+ * `columns`. `data` (row bitmaps, bit 15 = left column) is only read when
+ * `columns` is NULL: that path is kept for fonts written by hand and for
+ * tools/glyph_check.c, which uses it as the reference.
+ */
 typedef struct {
 	const uint8_t width;                /**< Font width in pixels */
 	const uint8_t height;               /**< Font height in pixels */
 	const uint16_t *const data;         /**< Pointer to font data array */
     const uint8_t *const char_width;    /**< Proportional character width in pixels (NULL for monospaced) */
+    const uint8_t *const columns;       /**< Glyphs in page layout, from tools/font_columns.py (NULL: drawn pixel by pixel) */
+    const uint8_t *const glyph_map;     /**< Glyph index per character 32-126, 0xFF if left out (NULL: all present) */
 } SSD1306_Font_t;
 
 // Procedure definitions
@@ -135,6 +157,11 @@ SSD1306_Error_t ssd1306_FillBuffer(uint8_t* buf, uint32_t len);
 
 // ==================== JÁ COM COMENTÁRIOS DE DOCUMENTAÇÃO API (Estilo doxygen) em ssd1306.c ====================
 
+bool ssd1306_Present(SSD1306_Callback_t callback, void *ctx);
+bool ssd1306_FlushBusy(void);
+void ssd1306_WaitFlush(void);
+void ssd1306_Invalidate(void);
+void ssd1306_GetStats(SSD1306_Stats_t *stats);
 void ssd1306_StartScrollRight(uint8_t startPage, uint8_t endPage, uint8_t scrollSpeed);
 void ssd1306_StartScrollLeft(uint8_t startPage, uint8_t endPage, uint8_t scrollSpeed);
 void ssd1306_StopScroll(void);
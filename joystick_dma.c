@@ -0,0 +1,201 @@
+/**
+ * @file joystick_dma.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Free-running joystick sampling through the ADC FIFO and DMA
+ *
+ * The data channel moves one 16-bit FIFO entry per ADC DREQ into the ring and
+ * chains to the control channel when the lap is complete. The control channel
+ * rewrites the data channel's write address through the trigger alias, which
+ * restarts it with the reloaded transfer count. The ring length is a whole
+ * number of frames, so frame boundaries never drift.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "joystick_dma.h"
+
+#define TEMP_SENSOR_INPUT   4
+
+// === Module State ===
+static uint16_t ring[JOYSTICK_DMA_FRAMES * 3] __attribute__((aligned(4)));
+static uint16_t *ring_start = ring;     // Source word for the control channel
+static int data_chan = -1;
+static int ctrl_chan = -1;
+static uint channels = 0;               // Samples per frame (2 or 3)
+static joystick_reader_t main_reader;   // Cursor of joystick_dma_consume()
+static volatile uint32_t lap_us = 0;    // Time for the DMA to fill the ring once
+static joystick_dma_stats_t joy_stats;
+
+// === Index of the frame the DMA is currently filling ===
+static uint write_frame(void) {
+    uintptr_t addr = dma_hw->ch[data_chan].write_addr;
+    uint sample = (uint)((addr - (uintptr_t)ring) / sizeof(ring[0]));
+    return (sample / channels) % JOYSTICK_DMA_FRAMES;
+}
+
+static void load_frame(uint index, joystick_frame_t *frame) {
+    const uint16_t *s = &ring[index * channels];
+    frame->x = s[0];
+    frame->y = s[1];
+    frame->temp = (channels > 2) ? s[2] : 0;
+}
+
+// === Frames completed since the reader's previous call ===
+static uint reader_pending(joystick_reader_t *reader) {
+    uint64_t now = time_us_64();
+    uint wr = write_frame();
+    uint count = (wr + JOYSTICK_DMA_FRAMES - reader->frame) % JOYSTICK_DMA_FRAMES;
+
+    // Too late: the ring has lapped, so only the newest lap is still valid
+    if (now - reader->last_read_us >= lap_us) {
+        reader->overruns++;
+        count = JOYSTICK_DMA_FRAMES - 1;
+        reader->frame = (wr + 1) % JOYSTICK_DMA_FRAMES;
+    }
+    reader->last_read_us = now;
+    return count;
+}
+
+static bool apply_rate(uint32_t frame_rate_hz) {
+    uint32_t conv_rate = frame_rate_hz * channels;
+    if (conv_rate < JOYSTICK_ADC_MIN_RATE || conv_rate > JOYSTICK_ADC_MAX_RATE) {
+        return false;
+    }
+    adc_set_clkdiv((float)clock_get_hz(clk_adc) / (float)conv_rate - 1.0f);
+    lap_us = (uint32_t)((uint64_t)JOYSTICK_DMA_FRAMES * 1000000 / frame_rate_hz);
+    joy_stats.frame_rate_hz = frame_rate_hz;
+    return true;
+}
+
+// === Start free-running conversions into the DMA ring ===
+bool joystick_dma_init(uint x_gpio, uint y_gpio, uint32_t frame_rate_hz, bool sample_temp) {
+    channels = sample_temp ? 3 : 2;
+    memset(&joy_stats, 0, sizeof(joy_stats));
+    if (!apply_rate(frame_rate_hz)) {
+        return false;
+    }
+
+    adc_gpio_init(x_gpio);
+    adc_gpio_init(y_gpio);
+    adc_set_temp_sensor_enabled(sample_temp);
+
+    // ADC0 -> ADC1 (-> ADC4), starting from ADC0 so each frame is x, y[, temp]
+    adc_select_input(0);
+    adc_set_round_robin(0x03 | (sample_temp ? (1u << TEMP_SENSOR_INPUT) : 0));
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_fifo_drain();
+
+    data_chan = dma_claim_unused_channel(true);
+    ctrl_chan = dma_claim_unused_channel(true);
+
+    dma_channel_config cfg = dma_channel_get_default_config(data_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_dreq(&cfg, DREQ_ADC);
+    channel_config_set_chain_to(&cfg, ctrl_chan);
+    dma_channel_configure(data_chan, &cfg, ring, &adc_hw->fifo,
+                          JOYSTICK_DMA_FRAMES * channels, false);
+
+    cfg = dma_channel_get_default_config(ctrl_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, false);
+    dma_channel_configure(ctrl_chan, &cfg, &dma_hw->ch[data_chan].al2_write_addr_trig,
+                          &ring_start, 1, false);
+
+    joystick_dma_reader_init(&main_reader);
+
+    dma_channel_start(data_chan);
+    adc_run(true);
+    return true;
+}
+
+// === Change the frame rate while running (frames stay aligned) ===
+bool joystick_dma_set_rate(uint32_t frame_rate_hz) {
+    return (data_chan >= 0) && apply_rate(frame_rate_hz);
+}
+
+uint joystick_dma_channels(void) {
+    return channels;
+}
+
+// === Most recent complete frame (does not consume) ===
+bool joystick_dma_latest(joystick_frame_t *frame) {
+    if (data_chan < 0) {
+        return false;
+    }
+    uint wr = write_frame();
+    load_frame((wr + JOYSTICK_DMA_FRAMES - 1) % JOYSTICK_DMA_FRAMES, frame);
+    return true;
+}
+
+// === Average of all frames completed since the previous call ===
+uint joystick_dma_consume(joystick_frame_t *mean) {
+    if (data_chan < 0) {
+        return 0;
+    }
+
+    uint count = reader_pending(&main_reader);
+    joy_stats.overruns = main_reader.overruns;
+    if (count == 0) {
+        return 0;
+    }
+
+    uint32_t sum_x = 0, sum_y = 0, sum_t = 0;
+    for (uint i = 0; i < count; i++) {
+        joystick_frame_t frame;
+        load_frame(main_reader.frame, &frame);
+        sum_x += frame.x;
+        sum_y += frame.y;
+        sum_t += frame.temp;
+        main_reader.frame = (main_reader.frame + 1) % JOYSTICK_DMA_FRAMES;
+    }
+
+    mean->x = (uint16_t)(sum_x / count);
+    mean->y = (uint16_t)(sum_y / count);
+    mean->temp = (uint16_t)(sum_t / count);
+    joy_stats.frames += count;
+    return count;
+}
+
+// === Start a reader at the current write position ===
+void joystick_dma_reader_init(joystick_reader_t *reader) {
+    reader->frame = (data_chan >= 0) ? write_frame() : 0;
+    reader->last_read_us = time_us_64();
+    reader->overruns = 0;
+}
+
+// === Copy up to max_frames raw frames (interleaved samples) for this reader ===
+uint joystick_dma_copy(joystick_reader_t *reader, uint16_t *dst, uint max_frames) {
+    if (data_chan < 0) {
+        return 0;
+    }
+
+    uint count = reader_pending(reader);
+    if (count > max_frames) {
+        count = max_frames;
+    }
+
+    // At most two runs: up to the end of the ring, then from its start
+    uint copied = 0;
+    while (copied < count) {
+        uint run = JOYSTICK_DMA_FRAMES - reader->frame;
+        if (run > count - copied) {
+            run = count - copied;
+        }
+        memcpy(&dst[copied * channels], &ring[reader->frame * channels],
+               run * channels * sizeof(ring[0]));
+        copied += run;
+        reader->frame = (reader->frame + run) % JOYSTICK_DMA_FRAMES;
+    }
+    return count;
+}
+
+void joystick_dma_get_stats(joystick_dma_stats_t *stats) {
+    *stats = joy_stats;
+}
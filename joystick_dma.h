@@ -0,0 +1,64 @@
+/**
+ * @file joystick_dma.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Free-running joystick sampling through the ADC FIFO and DMA
+ *
+ * The ADC converts continuously in round-robin over ADC0/ADC1 (and optionally
+ * the temperature sensor, ADC4) at a fixed frame rate. A DMA channel copies the
+ * FIFO into a RAM ring and a second channel re-arms it at the end of every
+ * lap, so no CPU time is spent on conversions. The application reads the
+ * ring position from the DMA write address and consumes whole frames. Each
+ * consumer keeps its own reader, so the trajectory log and a raw capture can
+ * tap the same ring independently.
+ */
+
+#ifndef JOYSTICK_DMA_H
+#define JOYSTICK_DMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/types.h"
+
+// === Build-time Configuration ===
+// Frames held in the DMA ring. The consumer must read at least once per lap
+// (JOYSTICK_DMA_FRAMES / frame rate) or older frames are overwritten.
+#ifndef JOYSTICK_DMA_FRAMES
+#define JOYSTICK_DMA_FRAMES     2048
+#endif
+
+// ADC conversion time is 96 clocks at 48 MHz; the 16-bit clock divider sets
+// the lower bound (48 MHz / 65536, about 733 conversions per second)
+#define JOYSTICK_ADC_MAX_RATE   500000
+#define JOYSTICK_ADC_MIN_RATE   733
+
+// === One round-robin frame (raw 12-bit codes) ===
+typedef struct {
+    uint16_t x;             // ADC0
+    uint16_t y;             // ADC1
+    uint16_t temp;          // ADC4, 0 when the sensor is not sampled
+} joystick_frame_t;
+
+// === Independent read cursor into the ring ===
+typedef struct {
+    uint frame;             // Next frame to read
+    uint64_t last_read_us;  // Time of the previous read, for lap detection
+    uint32_t overruns;      // Reads that came more than a ring lap late
+} joystick_reader_t;
+
+typedef struct {
+    uint32_t frames;        // Frames consumed by the application
+    uint32_t overruns;      // Consumes that came more than a ring lap late
+    uint32_t frame_rate_hz; // Configured frame rate
+} joystick_dma_stats_t;
+
+bool joystick_dma_init(uint x_gpio, uint y_gpio, uint32_t frame_rate_hz, bool sample_temp);
+bool joystick_dma_set_rate(uint32_t frame_rate_hz);
+uint joystick_dma_channels(void);
+bool joystick_dma_latest(joystick_frame_t *frame);
+uint joystick_dma_consume(joystick_frame_t *mean);
+void joystick_dma_reader_init(joystick_reader_t *reader);
+uint joystick_dma_copy(joystick_reader_t *reader, uint16_t *dst, uint max_frames);
+void joystick_dma_get_stats(joystick_dma_stats_t *stats);
+
+#endif // JOYSTICK_DMA_H
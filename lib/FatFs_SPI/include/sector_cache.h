@@ -0,0 +1,81 @@
+/**
+ * @file sector_cache.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Write-back sector cache between FatFs and a block device
+ *
+ * Small transfers (FAT, directory and partial-sector data) are served from
+ * an N-sector RAM cache with LRU eviction and dirty tracking. Dirty sectors
+ * are written back sorted by sector, with adjacent ones merged into one
+ * multi-block write. Transfers of SECTOR_CACHE_BYPASS sectors or more go
+ * straight to the device, after the cache has been reconciled with them.
+ *
+ * The device is reached only through the backend callbacks, so the cache
+ * builds and runs unchanged on a host against a disk image.
+ */
+
+#ifndef SECTOR_CACHE_H
+#define SECTOR_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// === Build-time Configuration ===
+#ifndef SECTOR_CACHE_SECTORS
+#define SECTOR_CACHE_SECTORS    16      // Cached sectors (8-32 is sensible)
+#endif
+
+#ifndef SECTOR_CACHE_BYPASS
+#define SECTOR_CACHE_BYPASS     4       // Transfers this long skip the cache
+#endif
+
+#ifndef SECTOR_CACHE_COALESCE
+#define SECTOR_CACHE_COALESCE   8       // Most sectors merged into one write-back
+#endif
+
+#define SECTOR_CACHE_SECTOR_SIZE 512
+
+// Backend calls return 0 on success, or a device error code that is passed
+// back to the caller unchanged
+typedef struct {
+    int (*read)(void *ctx, uint8_t *buffer, uint64_t sector, uint32_t count);
+    int (*write)(void *ctx, const uint8_t *buffer, uint64_t sector, uint32_t count);
+    void *ctx;
+} sector_cache_backend_t;
+
+typedef struct {
+    uint32_t hits;              // Sectors served from the cache
+    uint32_t misses;            // Sectors read from the device into the cache
+    uint32_t evictions;         // Valid sectors dropped to make room
+    uint32_t writebacks;        // Backend writes issued for dirty sectors
+    uint32_t written_back;      // Dirty sectors written by those writes
+    uint32_t bypassed;          // Sectors transferred without the cache
+} sector_cache_stats_t;
+
+typedef struct {
+    uint64_t sector;
+    uint32_t last_use;          // LRU stamp
+    bool valid;
+    bool dirty;
+} sector_cache_entry_t;
+
+typedef struct {
+    sector_cache_backend_t backend;
+    sector_cache_entry_t entries[SECTOR_CACHE_SECTORS];
+    uint8_t data[SECTOR_CACHE_SECTORS][SECTOR_CACHE_SECTOR_SIZE] __attribute__((aligned(4)));
+    uint8_t staging[SECTOR_CACHE_COALESCE * SECTOR_CACHE_SECTOR_SIZE] __attribute__((aligned(4)));
+    uint32_t clock;             // Source of LRU stamps
+    sector_cache_stats_t stats;
+} sector_cache_t;
+
+void sector_cache_init(sector_cache_t *cache, const sector_cache_backend_t *backend);
+int sector_cache_read(sector_cache_t *cache, uint8_t *buffer, uint64_t sector, uint32_t count);
+int sector_cache_write(sector_cache_t *cache, const uint8_t *buffer, uint64_t sector, uint32_t count);
+int sector_cache_flush(sector_cache_t *cache);
+void sector_cache_discard(sector_cache_t *cache, uint64_t sector, uint64_t count);
+void sector_cache_get_stats(const sector_cache_t *cache, sector_cache_stats_t *stats);
+
+// Cache in front of a FatFs physical drive, or NULL if it has none (glue.c)
+sector_cache_t *disk_get_cache(uint8_t pdrv);
+
+#endif // SECTOR_CACHE_H
@@ -96,6 +96,8 @@ char crc7(const char* data, int length)
 	return crc;
 }
 
+#if SD_CRC16_ENGINE == SD_CRC16_TABLE
+
 unsigned short crc16(const char* data, int length)
 {
 	//Calculate the CRC16 checksum for the specified data block
@@ -108,6 +110,74 @@ unsigned short crc16(const char* data, int length)
 	return crc;
 }
 
+#else
+
+#if SD_CRC16_ENGINE == SD_CRC16_SLICE8
+#define CRC16_SLICES 8
+#else
+#define CRC16_SLICES 4
+#endif
+
+/* Slicing tables: m_Crc16Slice[k][b] is the CRC of byte b followed by k zero
+ * bytes. A step over N bytes then needs one lookup per byte, all independent
+ * of each other, instead of N dependent table steps. Only the first two bytes
+ * of a step mix with the running CRC, since it is 16 bits wide. The tables
+ * are built in RAM on first use, which is also faster to read than XIP flash.
+ */
+static unsigned short m_Crc16Slice[CRC16_SLICES][256];
+static int m_Crc16SliceReady = 0;
+
+static void crc16_init_slices(void)
+{
+	for (int b = 0; b < 256; b++) {
+		m_Crc16Slice[0][b] = m_Crc16Table[b];
+	}
+	for (int k = 1; k < CRC16_SLICES; k++) {
+		for (int b = 0; b < 256; b++) {
+			unsigned short prev = m_Crc16Slice[k - 1][b];
+			m_Crc16Slice[k][b] = (prev << 8) ^ m_Crc16Table[prev >> 8];
+		}
+	}
+	m_Crc16SliceReady = 1;
+}
+
+unsigned short crc16(const char* data, int length)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	unsigned short crc = 0;
+
+	if (!m_Crc16SliceReady) {
+		crc16_init_slices();
+	}
+
+	//Whole steps of CRC16_SLICES bytes
+	while (length >= CRC16_SLICES) {
+#if CRC16_SLICES == 8
+		crc = m_Crc16Slice[7][((crc >> 8) ^ p[0]) & 0xFF] ^
+		      m_Crc16Slice[6][(crc ^ p[1]) & 0xFF] ^
+		      m_Crc16Slice[5][p[2]] ^ m_Crc16Slice[4][p[3]] ^
+		      m_Crc16Slice[3][p[4]] ^ m_Crc16Slice[2][p[5]] ^
+		      m_Crc16Slice[1][p[6]] ^ m_Crc16Slice[0][p[7]];
+#else
+		crc = m_Crc16Slice[3][((crc >> 8) ^ p[0]) & 0xFF] ^
+		      m_Crc16Slice[2][(crc ^ p[1]) & 0xFF] ^
+		      m_Crc16Slice[1][p[2]] ^ m_Crc16Slice[0][p[3]];
+#endif
+		p += CRC16_SLICES;
+		length -= CRC16_SLICES;
+	}
+
+	//Remaining bytes, one at a time
+	while (length-- > 0) {
+		crc = (crc << 8) ^ m_Crc16Table[((crc >> 8) ^ *p++) & 0x00FF];
+	}
+
+	//Return the calculated checksum
+	return crc;
+}
+
+#endif
+
 void update_crc16(unsigned short *pCrc16, const char data[], size_t length) {
 	for (size_t i = 0; i < length; i++) {
 		*pCrc16 = (*pCrc16 << 8) ^ m_Crc16Table[((*pCrc16 >> 8) ^ data[i]) & 0x00FF];
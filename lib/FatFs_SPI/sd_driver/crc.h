@@ -32,7 +32,25 @@ specific language governing permissions and limitations under the License.
 #define SD_CRC_H
 
 #include <stddef.h>
-    
+
+/* CRC16 engine for SD data blocks, selected at build time:
+ *   SD_CRC16_TABLE   one 256-entry table, one byte per step (original)
+ *   SD_CRC16_SLICE4  four tables, four bytes per step (2 KB of RAM)
+ *   SD_CRC16_SLICE8  eight tables, eight bytes per step (4 KB of RAM)
+ *   SD_CRC16_SNIFF   the RP2040 DMA sniffer computes the CRC of 512-byte
+ *                    blocks while they are transferred; crc16() itself
+ *                    falls back to slice-by-4 for everything else
+ * All engines compute the same CRC-16/XMODEM (poly 0x1021, init 0).
+ */
+#define SD_CRC16_TABLE 0
+#define SD_CRC16_SLICE4 1
+#define SD_CRC16_SLICE8 2
+#define SD_CRC16_SNIFF 3
+
+#ifndef SD_CRC16_ENGINE
+#define SD_CRC16_ENGINE SD_CRC16_SLICE8
+#endif
+
 char crc7(const char* data, int length);
 unsigned short crc16(const char* data, int length);
 void update_crc16(unsigned short *pCrc16, const char data[], size_t length);
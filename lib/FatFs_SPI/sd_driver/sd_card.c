@@ -182,6 +182,16 @@ specific language governing permissions and limitations under the License.
 #if SD_CRC_ENABLED
 #include "crc.h"
 static bool crc_on = true;
+// Data block CRCs come from the DMA sniffer instead of crc16()
+#define SD_CRC_SNIFF (SD_CRC16_ENGINE == SD_CRC16_SNIFF)
+#else
+#define SD_CRC_SNIFF 0
+#endif
+
+// Leave a multi-block write open after sd_write_blocks() so that a following
+// write to the next sector continues it instead of starting a new CMD25
+#ifndef SD_WRITE_SESSIONS
+#define SD_WRITE_SESSIONS 1
 #endif
 
 #define TRACE_PRINTF(fmt, args...)
@@ -296,7 +306,8 @@ typedef enum {
 
 static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
     uint8_t response;
-    char cmdPacket[PACKET_SIZE];
+    // One spare byte for the stuff byte that follows CMD12
+    char cmdPacket[PACKET_SIZE + 1];
 
     // Prepare the command packet
     cmdPacket[0] = SPI_CMD(cmd);
@@ -325,15 +336,14 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
                 break;
         }
     }
-    // send a command
-    for (int i = 0; i < PACKET_SIZE; i++) {
-        sd_spi_write(pSD, cmdPacket[i]);
-    }
     // The received byte immediataly following CMD12 is a stuff byte,
     // it should be discarded before receive the response of the CMD12.
+    size_t packet_len = PACKET_SIZE;
     if (CMD12_STOP_TRANSMISSION == cmd) {
-        sd_spi_write(pSD, SPI_FILL_CHAR);
+        cmdPacket[packet_len++] = SPI_FILL_CHAR;
     }
+    // send a command, in one transfer
+    sd_spi_transfer(pSD, (const uint8_t *)cmdPacket, NULL, packet_len);
     // Loop for response: Response is sent back within command response time
     // (NCR), 0 to 8 bytes for SDC
     for (int i = 0; i < 0x10; i++) {
@@ -346,21 +356,69 @@ static uint8_t sd_cmd_spi(sd_card_t *pSD, cmdSupported cmd, uint32_t arg) {
     return response;
 }
 
-static bool sd_wait_ready(sd_card_t *pSD, int timeout) {
-    char resp;
+// Bytes clocked per busy poll. Extra clocks after the card is ready are
+// harmless, so busy polling need not go one byte at a time.
+#define SD_BUSY_POLL_BYTES 4
 
+// While the card stays busy, the gap between polls doubles from the first
+// value to the second. The gap is spent in busy_yield() or asleep, so a long
+// flash program no longer keeps the CPU and the SPI spinning.
+#ifndef SD_BUSY_BACKOFF_MIN_US
+#define SD_BUSY_BACKOFF_MIN_US 8
+#endif
+#ifndef SD_BUSY_BACKOFF_MAX_US
+#define SD_BUSY_BACKOFF_MAX_US 512
+#endif
+
+static bool sd_poll_ready(sd_card_t *pSD) {
+    uint8_t poll[SD_BUSY_POLL_BYTES];
+    sd_spi_transfer(pSD, NULL, poll, sizeof poll);
+    return poll[sizeof poll - 1] != 0x00;
+}
+
+static void sd_busy_record(sd_card_t *pSD, uint32_t elapsed_us, bool ready_first,
+                           bool ready) {
+    sd_busy_stats_t *stats = &pSD->busy_stats;
+    if (ready_first) stats->ready_first++;
+    uint bucket = elapsed_us ? 32 - __builtin_clz(elapsed_us) : 0;
+    if (bucket >= SD_BUSY_HIST_BUCKETS) bucket = SD_BUSY_HIST_BUCKETS - 1;
+    stats->hist[bucket]++;
+    stats->waits++;
+    stats->total_us += elapsed_us;
+    if (elapsed_us > stats->max_us) stats->max_us = elapsed_us;
+    if (!ready) stats->timeouts++;
+}
+
+static bool sd_wait_ready(sd_card_t *pSD, int timeout) {
     // Keep sending dummy clocks with DI held high until the card releases the
     // DO line
-    absolute_time_t timeout_time = make_timeout_time_ms(timeout);
-    do {
-        resp = sd_spi_write(pSD, 0xFF);
-    } while (resp == 0x00 &&
-             0 < absolute_time_diff_us(get_absolute_time(), timeout_time));
+    absolute_time_t start = get_absolute_time();
+    absolute_time_t timeout_time = delayed_by_ms(start, timeout);
+    uint32_t gap_us = SD_BUSY_BACKOFF_MIN_US;
+    bool ready = sd_poll_ready(pSD);
+    bool ready_first = ready;
+    while (!ready && 0 < absolute_time_diff_us(get_absolute_time(), timeout_time)) {
+        absolute_time_t next_poll = make_timeout_time_us(gap_us);
+        if (pSD->busy_yield) {
+            pSD->busy_yield(pSD->busy_yield_ctx);
+        }
+        sleep_until(next_poll);  // Returns at once if the yield ran past it
+        if (gap_us < SD_BUSY_BACKOFF_MAX_US) gap_us *= 2;
+        ready = sd_poll_ready(pSD);
+    }
+    sd_busy_record(pSD, (uint32_t)absolute_time_diff_us(start, get_absolute_time()), ready_first,
+                   ready);
 
-    if (resp == 0x00) DBG_PRINTF("%s failed\r\n", __FUNCTION__);
+    if (!ready) DBG_PRINTF("%s failed\r\n", __FUNCTION__);
 
     // Return success/failure
-    return (resp > 0x00);
+    return ready;
+}
+
+void sd_set_busy_yield(sd_card_t *pSD, void (*yield)(void *ctx), void *ctx) {
+    pSD->busy_yield = NULL;  // Never pair a new hook with the old context
+    pSD->busy_yield_ctx = ctx;
+    pSD->busy_yield = yield;
 }
 
 // An SD card can only do one thing at a time.
@@ -383,6 +441,15 @@ static void sd_release(sd_card_t *pSD) {
     sd_spi_release(pSD);
 }
 
+void sd_get_busy_stats(sd_card_t *pSD, sd_busy_stats_t *stats, bool reset) {
+    sd_lock(pSD);
+    *stats = pSD->busy_stats;
+    if (reset) {
+        memset(&pSD->busy_stats, 0, sizeof pSD->busy_stats);
+    }
+    sd_unlock(pSD);
+}
+
 #if 0
 static const char *cmd2str(const cmdSupported cmd) {
     switch (cmd) {
@@ -523,13 +590,14 @@ static int sd_cmd(sd_card_t *pSD, const cmdSupported cmd, uint32_t arg,
             DBG_PRINTF("V2-Version Card\r\n");
             pSD->card_type = SDCARD_V2;  // fallthrough
             // Note: No break here, need to read rest of the response
-        case CMD58_READ_OCR:  // Response R3
-            response = (sd_spi_write(pSD, SPI_FILL_CHAR) << 24);
-            response |= (sd_spi_write(pSD, SPI_FILL_CHAR) << 16);
-            response |= (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-            response |= sd_spi_write(pSD, SPI_FILL_CHAR);
+        case CMD58_READ_OCR: {  // Response R3
+            uint8_t r3[R3_R7_RESPONSE_SIZE - R1_RESPONSE_SIZE];
+            sd_spi_transfer(pSD, NULL, r3, sizeof r3);
+            response = ((uint32_t)r3[0] << 24) | ((uint32_t)r3[1] << 16) |
+                       ((uint32_t)r3[2] << 8) | r3[3];
             DBG_PRINTF("R3/R7: 0x%" PRIx32 "\r\n", response);
             break;
+        }
         case CMD12_STOP_TRANSMISSION:  // Response R1b
         case CMD38_ERASE:
             sd_wait_ready(pSD, SD_COMMAND_TIMEOUT);
@@ -628,6 +696,8 @@ bool sd_card_detect(sd_card_t *pSD) {
         // The socket is now empty
         pSD->m_Status |= (STA_NODISK | STA_NOINIT);
         pSD->card_type = SDCARD_NONE;
+        pSD->ws_active = false;
+        pSD->ws_error = SD_BLOCK_DEVICE_ERROR_NONE;
         printf("No SD card detected!\r\n");
         return false;
     }
@@ -696,6 +766,22 @@ static uint32_t ext_bits(unsigned char *data, int msb, int lsb) {
 }
 
 static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length);
+static int sd_write_session_end_nolock(sd_card_t *pSD);
+static void sd_write_session_close_nolock(sd_card_t *pSD);
+static bool sd_clock_fall_back(sd_card_t *pSD, int status);
+
+// TRAN_SPEED : csd[103:96], the card's maximum data transfer rate.
+// Bits 2:0 are the rate unit, bits 6:3 a multiplier (in tenths).
+static uint32_t sd_tran_speed_hz(unsigned char *csd) {
+    static const uint32_t unit[] = {100000, 1000000, 10000000, 100000000};
+    static const uint8_t value_x10[] = {0,  10, 12, 13, 15, 20, 25, 30,
+                                        35, 40, 45, 50, 55, 60, 70, 80};
+    uint32_t tran_speed = ext_bits(csd, 103, 96);
+    if ((tran_speed & 0x7) > 3) return 0;
+    uint32_t hz = unit[tran_speed & 0x7] / 10 * value_x10[(tran_speed >> 3) & 0xF];
+    DBG_PRINTF("TRAN_SPEED 0x%02" PRIx32 ": %" PRIu32 " Hz\r\n", tran_speed, hz);
+    return hz;
+}
 
 static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
     uint32_t c_size, c_size_mult, read_bl_len;
@@ -713,6 +799,9 @@ static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
         DBG_PRINTF("Couldn't read csd response from disk\r\n");
         return 0;
     }
+    pSD->max_clock_hz = sd_tran_speed_hz(csd);
+    // erase_blk_en : csd[46], set if any range of blocks can be erased
+    pSD->erase_blk_en = ext_bits(csd, 46, 46);
     // csd_structure : csd[127:126]
     int csd_structure = ext_bits(csd, 127, 126);
     switch (csd_structure) {
@@ -729,6 +818,12 @@ static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
             capacity = (uint64_t)blocknr *
                        block_len;  // memory capacity = BLOCKNR * BLOCK_LEN
             blocks = capacity / _block_size;
+            // Erase group, for cards that predate the SD Status AU_SIZE:
+            // (sector_size : csd[45:39] + 1) write blocks of 2^write_bl_len
+            if (!pSD->au_sectors) {
+                pSD->au_sectors = (ext_bits(csd, 45, 39) + 1)
+                                  << (ext_bits(csd, 25, 22) - 9);
+            }
             DBG_PRINTF("Standard Capacity: c_size: %" PRIu32 "\r\n", c_size);
             DBG_PRINTF("Sectors: 0x%llx : %llu\r\n", blocks, blocks);
             DBG_PRINTF("Capacity: 0x%llx : %llu MB\r\n", capacity,
@@ -754,6 +849,7 @@ static uint64_t sd_sectors_nolock(sd_card_t *pSD) {
 }
 uint64_t sd_sectors(sd_card_t *pSD) {
     sd_acquire(pSD);
+    sd_write_session_close_nolock(pSD);
     uint64_t sectors = sd_sectors_nolock(pSD);
     sd_release(pSD);
     return sectors;
@@ -777,6 +873,13 @@ static bool sd_wait_token(sd_card_t *pSD, uint8_t token) {
 #define SPI_START_BLOCK \
     (0xFE) /*!< For Single Block Read/Write and Multiple Block Read */
 
+// The CRC16 trailer of a data block, big-endian, in one transfer
+static uint16_t sd_read_crc16(sd_card_t *pSD) {
+    uint8_t trailer[2];
+    sd_spi_transfer(pSD, NULL, trailer, sizeof trailer);
+    return (uint16_t)((trailer[0] << 8) | trailer[1]);
+}
+
 static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
     uint16_t crc;
 
@@ -786,12 +889,11 @@ static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
         return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
     // read data
-    for (uint32_t i = 0; i < length; i++) {
-        buffer[i] = sd_spi_write(pSD, SPI_FILL_CHAR);
+    if (!sd_spi_transfer(pSD, NULL, buffer, length)) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
     }
     // Read the CRC16 checksum for the data block
-    crc = (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-    crc |= sd_spi_write(pSD, SPI_FILL_CHAR);
+    crc = sd_read_crc16(pSD);
 
 #if SD_CRC_ENABLED
     if (crc_on) {
@@ -809,38 +911,76 @@ static int sd_read_bytes(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
 
     return 0;
 }
-static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length) {
-    uint16_t crc;
-
-    // read until start byte (0xFE)
-    if (false == sd_wait_token(pSD, SPI_START_BLOCK)) {
-        DBG_PRINTF("%s:%d Read timeout\r\n", __FILE__, __LINE__);
-        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
-    }
-    // read data
-    // bool spi_transfer(const uint8_t *tx, uint8_t *rx, size_t length)
-    if (!sd_spi_transfer(pSD, NULL, buffer, length)) {
-        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
-    }
-    // Read the CRC16 checksum for the data block
-    crc = (sd_spi_write(pSD, SPI_FILL_CHAR) << 8);
-    crc |= sd_spi_write(pSD, SPI_FILL_CHAR);
-
+// A received block whose CRC has not been checked yet
+typedef struct {
+    const uint8_t *data;  // NULL if none
+    uint16_t crc;         // CRC16 trailer sent by the card
+} pending_crc_t;
+
+static int sd_check_crc(pending_crc_t *pending, uint32_t length) {
+    const uint8_t *data = pending->data;
+    pending->data = NULL;
 #if SD_CRC_ENABLED
-    if (crc_on) {
+    if (data && crc_on) {
         uint32_t crc_result;
         // Compute and verify checksum
-        crc_result = crc16((void *)buffer, length);
-        if ((uint16_t)crc_result != crc) {
+        crc_result = crc16((void *)data, length);
+        if ((uint16_t)crc_result != pending->crc) {
             DBG_PRINTF("%s: Invalid CRC received 0x%" PRIx16
                        " result of computation 0x%" PRIx16 "\r\n",
-                       __FUNCTION__, crc, (uint16_t)crc_result);
+                       __FUNCTION__, pending->crc, (uint16_t)crc_result);
             return SD_BLOCK_DEVICE_ERROR_CRC;
         }
     }
+#else
+    (void)data;
+    (void)length;
 #endif
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
 
+/* Ping-pong: the previous block's CRC (pending) is checked while this block
+ * is received by DMA. On return, pending holds this block, to be checked by
+ * the next call or by sd_check_crc() after the last block. */
+static int sd_read_block(sd_card_t *pSD, uint8_t *buffer, uint32_t length,
+                         pending_crc_t *pending) {
+    // read until start byte (0xFE)
+    if (false == sd_wait_token(pSD, SPI_START_BLOCK)) {
+        DBG_PRINTF("%s:%d Read timeout\r\n", __FILE__, __LINE__);
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+#if SD_CRC_SNIFF
+    // read data; the DMA sniffer computes its CRC on the way in, so there is
+    // nothing left to defer
+    (void)pending;
+    if (!sd_spi_transfer_start_crc16(pSD, NULL, buffer, length) ||
+        !sd_spi_transfer_wait(pSD)) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    uint16_t crc_result = spi_sniffed_crc16();
+    // Read the CRC16 checksum for the data block
+    uint16_t crc = sd_read_crc16(pSD);
+    if (crc_on && crc_result != crc) {
+        DBG_PRINTF("%s: Invalid CRC received 0x%" PRIx16
+                   " result of computation 0x%" PRIx16 "\r\n",
+                   __FUNCTION__, crc, crc_result);
+        return SD_BLOCK_DEVICE_ERROR_CRC;
+    }
     return SD_BLOCK_DEVICE_ERROR_NONE;
+#else
+    // read data in the background
+    if (!sd_spi_transfer_start(pSD, NULL, buffer, length)) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    int status = sd_check_crc(pending, length);
+    if (!sd_spi_transfer_wait(pSD)) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    // Read the CRC16 checksum for the data block
+    pending->data = buffer;
+    pending->crc = sd_read_crc16(pSD);
+    return status;
+#endif
 }
 
 static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
@@ -852,8 +992,7 @@ static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
     if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
         return SD_BLOCK_DEVICE_ERROR_PARAMETER;
 
-    int status = SD_BLOCK_DEVICE_ERROR_NONE;
-
+    int status;
     uint64_t addr;
     // SDSC Card (CCS=0) uses byte unit address
     // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
@@ -873,14 +1012,18 @@ static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
     }
     // receive the data : one block at a time
     int rd_status = 0;
+    pending_crc_t pending = {NULL, 0};
     while (blockCnt) {
-        if (0 != sd_read_block(pSD, buffer, _block_size)) {
+        if (0 != sd_read_block(pSD, buffer, _block_size, &pending)) {
             rd_status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
             break;
         }
         buffer += _block_size;
         --blockCnt;
     }
+    if (!rd_status && 0 != sd_check_crc(&pending, _block_size)) {
+        rd_status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
     // Send CMD12(0x00000000) to stop the transmission for multi-block transfer
     if (ulSectorCount > 1) {
         status = sd_cmd(pSD, CMD12_STOP_TRANSMISSION, 0x0, false, 0);
@@ -893,7 +1036,12 @@ int sd_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
     sd_acquire(pSD);
     TRACE_PRINTF("sd_read_blocks(0x%p, 0x%llx, 0x%lx)\r\n", buffer,
                  ulSectorNumber, ulSectorCount);
+    // Before the transfer, so the retry below only ever covers the read
+    sd_write_session_close_nolock(pSD);
     int status = in_sd_read_blocks(pSD, buffer, ulSectorNumber, ulSectorCount);
+    if (sd_clock_fall_back(pSD, status)) {
+        status = in_sd_read_blocks(pSD, buffer, ulSectorNumber, ulSectorCount);
+    }
     sd_release(pSD);
     return status;
 }
@@ -906,23 +1054,34 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
     // indicate start of block
     sd_spi_write(pSD, token);
 
-    // write the data
-    bool ret = sd_spi_transfer(pSD, buffer, NULL, length);
+    // write the data in the background
+#if SD_CRC_SNIFF
+    // The DMA sniffer computes the CRC on the way out
+    bool ret = sd_spi_transfer_start_crc16(pSD, buffer, NULL, length);
+#else
+    bool ret = sd_spi_transfer_start(pSD, buffer, NULL, length);
+#endif
     myASSERT(ret);
 
-#if SD_CRC_ENABLED
+#if SD_CRC_ENABLED && !SD_CRC_SNIFF
     if (crc_on) {
-        // Compute CRC
+        // Compute CRC while the block is on the wire
         crc = crc16((void *)buffer, length);
     }
 #endif
+    ret = sd_spi_transfer_wait(pSD);
+    myASSERT(ret);
+#if SD_CRC_SNIFF
+    if (crc_on) {
+        crc = spi_sniffed_crc16();
+    }
+#endif
 
-    // write the checksum CRC16
-    sd_spi_write(pSD, crc >> 8);
-    sd_spi_write(pSD, crc);
-
-    // check the response token
-    response = sd_spi_write(pSD, SPI_FILL_CHAR);
+    // write the checksum CRC16 and clock in the response token, together
+    uint8_t trailer[3] = {crc >> 8, crc, SPI_FILL_CHAR};
+    uint8_t reply[3];
+    sd_spi_transfer(pSD, trailer, reply, sizeof trailer);
+    response = reply[2];
 
     // Wait for last block to be written
     if (false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
@@ -931,6 +1090,168 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
     return (response & SPI_DATA_RESPONSE_MASK);
 }
 
+static uint64_t sd_block_addr(sd_card_t *pSD, uint64_t ulSectorNumber) {
+    // SDSC Card (CCS=0) uses byte unit address
+    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
+    if (SDCARD_V2HC == pSD->card_type) {
+        return ulSectorNumber;
+    } else {
+        return ulSectorNumber * _block_size;
+    }
+}
+
+/* Write sessions
+ * --------------
+ * A session is a CMD25 that stays open between calls. Blocks are appended with
+ * the multi-block start token as they arrive; the 'Stop Tran' token and the
+ * CMD13 status check are sent only once, when the session ends. The card sits
+ * in the receive-data state in between, which tolerates CS being released.
+ *
+ * Any other transaction on the card (reads, CMD9, a write elsewhere) ends the
+ * session first, so a session is never left open underneath another command.
+ * The CMD13 status of that end belongs to the blocks already written, not to
+ * the read or erase that triggered it: it is kept in ws_error and returned by
+ * the next sd_write_blocks() or sd_sync().
+ */
+
+static int sd_write_session_end_nolock(sd_card_t *pSD) {
+    if (!pSD->ws_active) {
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    pSD->ws_active = false;
+
+    /* In a Multiple Block write operation, the stop transmission will be
+     * done by sending 'Stop Tran' token instead of 'Start Block' token at
+     * the beginning of the next block
+     */
+    sd_spi_write(pSD, SPI_STOP_TRAN);
+
+    uint32_t stat = 0;
+    // Some SD cards want to be deselected between every bus transaction:
+    sd_spi_deselect_pulse(pSD);
+    return sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+}
+
+// End the session for a transaction other than a write or a sync
+static void sd_write_session_close_nolock(sd_card_t *pSD) {
+    int status = sd_write_session_end_nolock(pSD);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status &&
+        SD_BLOCK_DEVICE_ERROR_NONE == pSD->ws_error) {
+        pSD->ws_error = status;
+    }
+}
+
+// Take the error of a session ended by sd_write_session_close_nolock()
+static int sd_write_session_error_nolock(sd_card_t *pSD) {
+    int status = pSD->ws_error;
+    pSD->ws_error = SD_BLOCK_DEVICE_ERROR_NONE;
+    return status;
+}
+
+static int sd_write_session_begin_nolock(sd_card_t *pSD, uint64_t ulSectorNumber,
+                                         uint32_t blockCnt) {
+    int status = sd_write_session_end_nolock(pSD);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        return status;
+    }
+    if (ulSectorNumber + blockCnt > pSD->sectors ||
+        ulSectorNumber >= pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+
+    // Pre-erase setting prior to multiple block write operation. It is only a
+    // hint: writing past it is allowed, the extra blocks are just not pre-erased.
+    if (blockCnt) {
+        sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
+    }
+
+    // Some SD cards want to be deselected between every bus transaction:
+    sd_spi_deselect_pulse(pSD);
+
+    // Multiple block write command
+    status = sd_cmd(pSD, CMD25_WRITE_MULTIPLE_BLOCK,
+                    sd_block_addr(pSD, ulSectorNumber), false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        pSD->ws_active = true;
+        pSD->ws_next_sector = ulSectorNumber;
+    }
+    return status;
+}
+
+static int sd_write_session_append_nolock(sd_card_t *pSD, const uint8_t *buffer,
+                                          uint32_t blockCnt) {
+    if (!pSD->ws_active)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->ws_next_sector + blockCnt > pSD->sectors) {
+        sd_write_session_end_nolock(pSD);
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    }
+
+    // Write the data: one block at a time
+    while (blockCnt) {
+        uint8_t response =
+            sd_write_block(pSD, buffer, SPI_START_BLK_MUL_WRITE, _block_size);
+        if (response != SPI_DATA_ACCEPTED) {
+            DBG_PRINTF("Multiple Block Write failed: 0x%x\r\n", response);
+            sd_write_session_end_nolock(pSD);
+            return SD_BLOCK_DEVICE_ERROR_WRITE;
+        }
+        buffer += _block_size;
+        ++pSD->ws_next_sector;
+        --blockCnt;
+    }
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+/** Start a write session at a sector
+ *
+ *  @param ulSectorNumber   Logical Address of block to begin writing to (LBA)
+ *  @param blockCnt         Expected length of the session in blocks, used as
+ *                          the pre-erase hint; 0 if unknown
+ *  @return         SD_BLOCK_DEVICE_ERROR_NONE(0) - success, or as sd_cmd()
+ */
+int sd_write_session_begin(sd_card_t *pSD, uint64_t ulSectorNumber,
+                           uint32_t blockCnt) {
+    sd_acquire(pSD);
+    int status = sd_write_session_begin_nolock(pSD, ulSectorNumber, blockCnt);
+    sd_release(pSD);
+    return status;
+}
+
+/** Write blocks at the current position of the open session
+ *
+ *  @return         SD_BLOCK_DEVICE_ERROR_NONE(0) - success
+ *                  SD_BLOCK_DEVICE_ERROR_PARAMETER - no session is open, or
+ *  the write would pass the end of the card
+ *                  SD_BLOCK_DEVICE_ERROR_WRITE - SPI write error; the session
+ *  is ended
+ */
+int sd_write_session_append(sd_card_t *pSD, const uint8_t *buffer,
+                            uint32_t blockCnt) {
+    sd_acquire(pSD);
+    int status = sd_write_session_append_nolock(pSD, buffer, blockCnt);
+    sd_release(pSD);
+    return status;
+}
+
+/** End the open session, if any, and check the card status (CMD13)
+ *
+ *  Also returns the error of a session that an earlier read or erase ended.
+ */
+int sd_write_session_end(sd_card_t *pSD) {
+    if (!pSD->ws_active && SD_BLOCK_DEVICE_ERROR_NONE == pSD->ws_error) {
+        return SD_BLOCK_DEVICE_ERROR_NONE;
+    }
+    sd_acquire(pSD);
+    int status = sd_write_session_error_nolock(pSD);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        status = sd_write_session_end_nolock(pSD);
+    }
+    sd_release(pSD);
+    return status;
+}
+
 /** Program blocks to a block device
  *
  *
@@ -945,6 +1266,11 @@ static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
  *                  SD_BLOCK_DEVICE_ERROR_NO_INIT - device is not initialized
  *                  SD_BLOCK_DEVICE_ERROR_WRITE - SPI write error
  *                  SD_BLOCK_DEVICE_ERROR_ERASE - erase error
+ *
+ *  With SD_WRITE_SESSIONS, a multi-block write leaves its session open, and a
+ *  write that starts where the open session stopped is appended to it.
+ *  Errors from the final CMD13 are then reported when the session ends, or
+ *  by the next write if a read or erase ended it; that write is not done.
  */
 static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
                               uint64_t ulSectorNumber, uint32_t blockCnt) {
@@ -953,64 +1279,49 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
         return SD_BLOCK_DEVICE_ERROR_PARAMETER;
 
-    int status = SD_BLOCK_DEVICE_ERROR_NONE;
-    uint8_t response;
-    uint64_t addr;
+    // Sequential with the open session: no command, no status round trip
+    if (pSD->ws_active && ulSectorNumber == pSD->ws_next_sector) {
+        return sd_write_session_append_nolock(pSD, buffer, blockCnt);
+    }
 
-    // SDSC Card (CCS=0) uses byte unit address
-    // SDHC and SDXC Cards (CCS=1) use block unit address (512 Bytes unit)
-    if (SDCARD_V2HC == pSD->card_type) {
-        addr = ulSectorNumber;
-    } else {
-        addr = ulSectorNumber * _block_size;
+    int status = sd_write_session_end_nolock(pSD);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        return status;
     }
+
     // Send command to perform write operation
     if (blockCnt == 1) {
         // Single block write command
         if (SD_BLOCK_DEVICE_ERROR_NONE !=
-            (status = sd_cmd(pSD, CMD24_WRITE_BLOCK, addr, false, 0))) {
+            (status = sd_cmd(pSD, CMD24_WRITE_BLOCK,
+                             sd_block_addr(pSD, ulSectorNumber), false, 0))) {
             return status;
         }
         // Write data
-        response = sd_write_block(pSD, buffer, SPI_START_BLOCK, _block_size);
+        uint8_t response = sd_write_block(pSD, buffer, SPI_START_BLOCK, _block_size);
 
         // Only CRC and general write error are communicated via response token
         if (response != SPI_DATA_ACCEPTED) {
             DBG_PRINTF("Single Block Write failed: 0x%x \r\n", response);
             status = SD_BLOCK_DEVICE_ERROR_WRITE;
         }
-    } else {
-        // Pre-erase setting prior to multiple block write operation
-        sd_cmd(pSD, ACMD23_SET_WR_BLK_ERASE_COUNT, blockCnt, 1, 0);
-
+        uint32_t stat = 0;
         // Some SD cards want to be deselected between every bus transaction:
         sd_spi_deselect_pulse(pSD);
+        status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+        return status;
+    }
 
-        // Multiple block write command
-        if (SD_BLOCK_DEVICE_ERROR_NONE !=
-            (status = sd_cmd(pSD, CMD25_WRITE_MULTIPLE_BLOCK, addr, false, 0))) {
-            return status;
-        }
-        // Write the data: one block at a time
-        do {
-            response = sd_write_block(pSD, buffer, SPI_START_BLK_MUL_WRITE, _block_size);
-            if (response != SPI_DATA_ACCEPTED) {
-                DBG_PRINTF("Multiple Block Write failed: 0x%x\r\n", response);
-                status = SD_BLOCK_DEVICE_ERROR_WRITE;
-                break;
-            }
-            buffer += _block_size;
-        } while (--blockCnt);  // Send all blocks of data
-        /* In a Multiple Block write operation, the stop transmission will be
-         * done by sending 'Stop Tran' token instead of 'Start Block' token at
-         * the beginning of the next block
-         */
-        sd_spi_write(pSD, SPI_STOP_TRAN);
+    status = sd_write_session_begin_nolock(pSD, ulSectorNumber, blockCnt);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        return status;
     }
-    uint32_t stat = 0;
-    // Some SD cards want to be deselected between every bus transaction:
-    sd_spi_deselect_pulse(pSD);
-    status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    status = sd_write_session_append_nolock(pSD, buffer, blockCnt);
+#if !SD_WRITE_SESSIONS
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        status = sd_write_session_end_nolock(pSD);
+    }
+#endif
     return status;
 }
 
@@ -1019,11 +1330,216 @@ int sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     sd_acquire(pSD);
     TRACE_PRINTF("sd_write_blocks(0x%p, 0x%llx, 0x%lx)\r\n", buffer,
                  ulSectorNumber, blockCnt);
-    int status = in_sd_write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    int status = sd_write_session_error_nolock(pSD);
+    // End a session this write does not continue before the transfer: its
+    // error is about earlier blocks and is returned as is, without a retry
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status && pSD->ws_active &&
+        ulSectorNumber != pSD->ws_next_sector) {
+        status = sd_write_session_end_nolock(pSD);
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        sd_release(pSD);
+        return status;
+    }
+    status = in_sd_write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    if (sd_clock_fall_back(pSD, status)) {
+        status = in_sd_write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
+    }
     sd_release(pSD);
     return status;
 }
 
+/* Erase geometry, sync and trim
+ * -----------------------------
+ * The allocation unit (AU) is the card's erase block: writes that fill whole,
+ * aligned AUs are the fastest, which is why f_mkfs asks for it to align the
+ * data area. It comes from the 512-bit SD Status (ACMD13).
+ */
+#define SD_STATUS_SIZE 64
+// Erase time allowed per allocation unit when the card does not say
+#define SD_ERASE_TIMEOUT_PER_AU 250
+
+// AU_SIZE : SD Status[431:428]. 12 and 24 MB are reported as their largest
+// power-of-two divisor and all sizes are capped at 32768 sectors, the limits
+// of GET_BLOCK_SIZE.
+static void sd_read_au_size_nolock(sd_card_t *pSD) {
+    static const uint32_t au_kb[16] = {0,    16,   32,    64,    128,   256,
+                                       512,  1024, 2048,  4096,  8192,  12288,
+                                       16384, 24576, 32768, 65536};
+    uint8_t status[SD_STATUS_SIZE];
+    // ACMD13, Response R2 (R1 byte + status byte), then a 64-byte data block
+    if (sd_cmd(pSD, ACMD13_SD_STATUS, 0x0, true, 0) != SD_BLOCK_DEVICE_ERROR_NONE ||
+        sd_read_bytes(pSD, status, sizeof status) != 0) {
+        DBG_PRINTF("Couldn't read SD Status\r\n");
+        return;
+    }
+    uint32_t sectors = au_kb[status[10] >> 4] * 2;
+    if (!sectors) return;
+    sectors &= -sectors;
+    if (sectors > 32768) sectors = 32768;
+    pSD->au_sectors = sectors;
+    DBG_PRINTF("AU: %" PRIu32 " sectors\r\n", sectors);
+}
+
+/** Commit all written data to flash
+ *
+ *  Ends the open write session and waits until the card has finished
+ *  programming. An error kept from a session that a read or erase ended is
+ *  returned here if no write has reported it yet.
+ *  @return         SD_BLOCK_DEVICE_ERROR_NONE(0) - success
+ *                  SD_BLOCK_DEVICE_ERROR_NO_RESPONSE - still busy at timeout
+ *                  or as sd_write_session_end()
+ */
+int sd_sync(sd_card_t *pSD) {
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_NO_INIT;
+    sd_acquire(pSD);
+    int status = sd_write_session_end_nolock(pSD);
+    int kept = sd_write_session_error_nolock(pSD);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) {
+        status = kept;
+    }
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status &&
+        false == sd_wait_ready(pSD, SD_COMMAND_TIMEOUT)) {
+        status = SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    sd_release(pSD);
+    return status;
+}
+
+static int in_sd_trim(sd_card_t *pSD, uint64_t first, uint64_t last) {
+    if (first > last || last >= pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    if (pSD->m_Status & (STA_NOINIT | STA_NODISK))
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    // Without ERASE_BLK_EN a card erases whole erase groups, which would take
+    // neighbouring data with it
+    if (!pSD->erase_blk_en)
+        return SD_BLOCK_DEVICE_ERROR_UNSUPPORTED;
+
+    sd_write_session_close_nolock(pSD);
+    int status = sd_cmd(pSD, CMD32_ERASE_WR_BLK_START_ADDR, sd_block_addr(pSD, first),
+                    false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        return status;
+    }
+    status = sd_cmd(pSD, CMD33_ERASE_WR_BLK_END_ADDR, sd_block_addr(pSD, last),
+                    false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        return status;
+    }
+    status = sd_cmd(pSD, CMD38_ERASE, 0x0, false, 0);
+    if (SD_BLOCK_DEVICE_ERROR_NONE != status) {
+        return status;
+    }
+    // sd_cmd() only waited SD_COMMAND_TIMEOUT; a large erase takes longer
+    uint64_t aus = (last - first) / (pSD->au_sectors ? pSD->au_sectors : 1) + 1;
+    uint64_t timeout = SD_COMMAND_TIMEOUT + aus * SD_ERASE_TIMEOUT_PER_AU;
+    if (timeout > INT32_MAX) timeout = INT32_MAX;
+    if (false == sd_wait_ready(pSD, (int)timeout)) {
+        return SD_BLOCK_DEVICE_ERROR_ERASE;
+    }
+    uint32_t stat = 0;
+    // Some SD cards want to be deselected between every bus transaction:
+    sd_spi_deselect_pulse(pSD);
+    return sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+}
+
+/** Erase a range of blocks (CMD32/33/38) that no longer hold data
+ *
+ *  @param first    First block of the range (LBA)
+ *  @param last     Last block of the range, inclusive
+ *  @return         SD_BLOCK_DEVICE_ERROR_NONE(0) - success
+ *                  SD_BLOCK_DEVICE_ERROR_UNSUPPORTED - the card can only
+ *  erase whole erase groups
+ *                  SD_BLOCK_DEVICE_ERROR_ERASE - erase error or timeout
+ */
+int sd_trim(sd_card_t *pSD, uint64_t first, uint64_t last) {
+    sd_acquire(pSD);
+    int status = in_sd_trim(pSD, first, last);
+    sd_release(pSD);
+    return status;
+}
+
+/* Clock negotiation
+ * -----------------
+ * After initialization the clock is raised in steps (doubling from
+ * SD_CLOCK_STEP_MIN_HZ) towards the lower of the CSD TRAN_SPEED and the
+ * configured spi_t.baud_rate. Each step is verified by reading sector 0 and
+ * comparing it, CRC-checked, with the copy read at the initialization clock;
+ * the first failing step ends the climb at the last good one. If that copy
+ * cannot be read, the clock stays at the initialization clock. Later CRC,
+ * timeout (with the card still detected) or data-response errors halve the
+ * clock, count in clock_fallbacks, and retry once. The open
+ * write session is ended before that transfer, so its status is never taken
+ * for one.
+ */
+#define SD_CLOCK_STEP_MIN_HZ (1000 * 1000)
+
+static uint8_t clock_ref_block[BLOCK_SIZE_HC];
+static uint8_t clock_test_block[BLOCK_SIZE_HC];
+
+static int in_sd_read_blocks(sd_card_t *pSD, uint8_t *buffer,
+                             uint64_t ulSectorNumber, uint32_t ulSectorCount);
+
+static bool sd_clock_verify(sd_card_t *pSD) {
+    // Twice, so a marginal clock has two chances to show itself
+    for (int i = 0; i < 2; i++) {
+        if (in_sd_read_blocks(pSD, clock_test_block, 0, 1) != SD_BLOCK_DEVICE_ERROR_NONE ||
+            memcmp(clock_test_block, clock_ref_block, sizeof clock_test_block) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void sd_clock_step_up(sd_card_t *pSD) {
+    uint32_t limit = pSD->spi->baud_rate;
+    if (pSD->max_clock_hz && pSD->max_clock_hz < limit) limit = pSD->max_clock_hz;
+
+    // Reference copy at the initialization clock
+    if (in_sd_read_blocks(pSD, clock_ref_block, 0, 1) != SD_BLOCK_DEVICE_ERROR_NONE) {
+        // Nothing to verify against, and the card already failed at the
+        // slowest clock: stay there
+        DBG_PRINTF("Reference read at %" PRIu32 " Hz failed, SPI clock not raised\r\n",
+                   pSD->clock_hz);
+        return;
+    }
+
+    uint32_t good = pSD->clock_hz;
+    uint32_t target = SD_CLOCK_STEP_MIN_HZ;
+    for (;;) {
+        if (target > limit) target = limit;
+        uint32_t actual = sd_spi_set_frequency(pSD, target);
+        if (actual <= good) break;  // The divider cannot go any higher
+        if (!sd_clock_verify(pSD)) {
+            DBG_PRINTF("SPI clock %" PRIu32 " Hz failed verification\r\n", actual);
+            break;
+        }
+        good = actual;
+        if (target == limit) break;
+        target *= 2;
+    }
+    pSD->clock_hz = sd_spi_set_frequency(pSD, good);
+}
+
+// Called with a failed transfer's status; true if the clock was lowered and
+// the transfer is worth retrying. NO_RESPONSE is also what a pulled card
+// gives, so it only counts while the card is still detected.
+static bool sd_clock_fall_back(sd_card_t *pSD, int status) {
+    if (status != SD_BLOCK_DEVICE_ERROR_CRC &&
+        status != SD_BLOCK_DEVICE_ERROR_WRITE &&
+        !(status == SD_BLOCK_DEVICE_ERROR_NO_RESPONSE && sd_card_detect(pSD)))
+        return false;
+    if (pSD->clock_hz / 2 < SD_CLOCK_STEP_MIN_HZ)
+        return false;
+    pSD->clock_hz = sd_spi_set_frequency(pSD, pSD->clock_hz / 2);
+    pSD->clock_fallbacks++;
+    DBG_PRINTF("Transfer error %d, SPI clock lowered to %" PRIu32 " Hz\r\n", status,
+               pSD->clock_hz);
+    return true;
+}
+
 static int sd_init_medium(sd_card_t *pSD) {
     int32_t status = SD_BLOCK_DEVICE_ERROR_NONE;
     uint32_t response, arg;
@@ -1199,6 +1715,9 @@ static int sd_init(sd_card_t *pSD) {
     }
     // Initialize the member variables
     pSD->card_type = SDCARD_NONE;
+    pSD->ws_active = false;
+    pSD->ws_error = SD_BLOCK_DEVICE_ERROR_NONE;
+    pSD->au_sectors = 0;
 
     sd_spi_acquire(pSD);
 
@@ -1224,12 +1743,15 @@ static int sd_init(sd_card_t *pSD) {
         sd_unlock(pSD);
         return pSD->m_Status;
     }
-    // Set SCK for data transfer
-    sd_spi_go_high_frequency(pSD);
-
     // The card is now initialized
     pSD->m_Status &= ~STA_NOINIT;
 
+    // Set SCK for data transfer: as fast as the card and the bus allow
+    pSD->clock_hz = sd_spi_set_frequency(pSD, 400 * 1000);
+    sd_clock_step_up(pSD);
+    DBG_PRINTF("SPI clock: %" PRIu32 " Hz\r\n", pSD->clock_hz);
+    sd_read_au_size_nolock(pSD);
+
     sd_spi_release(pSD);
     sd_unlock(pSD);
 
@@ -1247,6 +1769,7 @@ static bool sd_test_com(sd_card_t *pSD) {
 
     if (!(pSD->m_Status & STA_NOINIT)) {
         // SD card is currently initialized
+        sd_write_session_close_nolock(pSD);
 
         // Timeout of 0 means only check once
         if (sd_wait_ready(pSD, 0)) {
@@ -1265,6 +1788,7 @@ static bool sd_test_com(sd_card_t *pSD) {
             if (!success) {
                 // Card no longer sensed - ensure card is initialized once re-attached
                 pSD->m_Status |= STA_NOINIT;
+                pSD->ws_active = false;
             }
         } else {
             // SD card is currently holding DO which is sufficient enough to know it's still there
@@ -32,6 +32,21 @@ extern "C" {
 
 typedef struct sd_card_t sd_card_t;
 
+// Busy-wait histogram of wait times, first poll included: bucket 0 counts
+// waits under 1 us, bucket i (i > 0) waits of [2^(i-1), 2^i) us; the
+// last one is open. The first poll itself takes a few us, so waits where the
+// card was already ready are counted in ready_first instead.
+#define SD_BUSY_HIST_BUCKETS 20
+
+typedef struct {
+    uint32_t waits;                             // Calls to sd_wait_ready()
+    uint32_t ready_first;                       // Waits ready on the first poll
+    uint32_t timeouts;                          // Waits that gave up
+    uint32_t max_us;                            // Longest wait
+    uint64_t total_us;                          // Time spent waiting
+    uint32_t hist[SD_BUSY_HIST_BUCKETS];
+} sd_busy_stats_t;
+
 // "Class" representing SD Cards
 struct sd_card_t {
     const char *pcName;
@@ -54,6 +69,19 @@ struct sd_card_t {
     mutex_t mutex;
     FATFS fatfs;
     bool mounted;
+    uint32_t max_clock_hz;                           // From CSD TRAN_SPEED
+    uint32_t clock_hz;                               // SPI clock chosen at init
+    uint32_t clock_fallbacks;                        // Times a transfer error halved clock_hz
+    uint32_t au_sectors;                             // Erase block (AU); 0 if unknown
+    bool erase_blk_en;                               // Any block range is erasable
+    // Called between polls while the card is busy programming, with the card
+    // and its SPI still held: it must not touch this card. NULL to just sleep.
+    void (*busy_yield)(void *ctx);
+    void *busy_yield_ctx;
+    sd_busy_stats_t busy_stats;
+    bool ws_active;                                  // A CMD25 write session is open
+    uint64_t ws_next_sector;                         // Next sector of the open session
+    int ws_error;                                    // Session end error not yet reported
 
     int (*init)(sd_card_t *sd_card_p);
     int (*write_blocks)(sd_card_t *sd_card_p, const uint8_t *buffer,
@@ -90,6 +118,19 @@ struct sd_card_t {
 bool sd_card_detect(sd_card_t *pSD);
 uint64_t sd_sectors(sd_card_t *pSD);
 
+// Open-ended multi-block write: one CMD25 kept open across many appends.
+// blockCnt is the pre-erase hint for begin (0 if unknown).
+int sd_write_session_begin(sd_card_t *pSD, uint64_t ulSectorNumber, uint32_t blockCnt);
+int sd_write_session_append(sd_card_t *pSD, const uint8_t *buffer, uint32_t blockCnt);
+int sd_write_session_end(sd_card_t *pSD);
+
+// Wait for programming to finish; erase blocks that no longer hold data
+int sd_sync(sd_card_t *pSD);
+int sd_trim(sd_card_t *pSD, uint64_t first, uint64_t last);
+
+void sd_set_busy_yield(sd_card_t *pSD, void (*yield)(void *ctx), void *ctx);
+void sd_get_busy_stats(sd_card_t *pSD, sd_busy_stats_t *stats, bool reset);
+
 bool sd_init_driver();
 bool sd_card_detect(sd_card_t *sd_card_p);
 
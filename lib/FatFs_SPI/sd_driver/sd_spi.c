@@ -31,8 +31,13 @@ specific language governing permissions and limitations under the License.
 #pragma GCC diagnostic ignored "-Wunused-variable"
 
 void sd_spi_go_high_frequency(sd_card_t *pSD) {
-    uint actual = spi_set_baudrate(pSD->spi->hw_inst, pSD->spi->baud_rate);
+    sd_spi_set_frequency(pSD, pSD->spi->baud_rate);
+}
+// Returns the frequency actually set (the nearest the SPI divider allows)
+uint sd_spi_set_frequency(sd_card_t *pSD, uint hz) {
+    uint actual = spi_set_baudrate(pSD->spi->hw_inst, hz);
     TRACE_PRINTF("%s: Actual frequency: %lu\n", __FUNCTION__, (long)actual);
+    return actual;
 }
 void sd_spi_go_low_frequency(sd_card_t *pSD) {
     uint actual = spi_set_baudrate(pSD->spi->hw_inst, 400 * 1000); // Actual frequency: 398089
@@ -91,16 +96,27 @@ bool sd_spi_transfer(sd_card_t *pSD, const uint8_t *tx, uint8_t *rx,
     return spi_transfer(pSD->spi, tx, rx, length);
 }
 
+// Start a bulk transfer in the background; finish it with sd_spi_transfer_wait()
+bool sd_spi_transfer_start(sd_card_t *pSD, const uint8_t *tx, uint8_t *rx,
+                           size_t length) {
+    return spi_transfer_async(pSD->spi, tx, rx, length, NULL, NULL);
+}
+
+// As sd_spi_transfer_start(), with the DMA sniffer computing the block's CRC16
+bool sd_spi_transfer_start_crc16(sd_card_t *pSD, const uint8_t *tx, uint8_t *rx,
+                                 size_t length) {
+    return spi_transfer_async_crc16(pSD->spi, tx, rx, length);
+}
+
+bool sd_spi_transfer_wait(sd_card_t *pSD) {
+    return spi_transfer_wait(pSD->spi);
+}
+
 uint8_t sd_spi_write(sd_card_t *pSD, const uint8_t value) {
     // TRACE_PRINTF("%s\n", __FUNCTION__);
     uint8_t received = SPI_FILL_CHAR;
-#if 0
-    int num = spi_write_read_blocking(pSD->spi->hw_inst, &value, &received, 1);
-    myASSERT(1 == num);
-#else
     bool success = spi_transfer(pSD->spi, &value, &received, 1);
     myASSERT(success);
-#endif
     return received;
 }
 
@@ -14,6 +14,7 @@ specific language governing permissions and limitations under the License.
 
 #include <assert.h>
 #include <stdbool.h>
+#include <string.h>
 //
 #include "pico/stdlib.h"
 #include "pico/mutex.h"
@@ -38,6 +39,11 @@ static void in_spi_irq_handler(const uint DMA_IRQ_num, io_rw_32 *dma_hw_ints_p)
                 assert(!sem_available(&spi_p->sem));
                 bool ok = sem_release(&spi_p->sem);
                 assert(ok);
+                if (spi_p->callback) {
+                    spi_callback_t callback = spi_p->callback;
+                    spi_p->callback = NULL;
+                    callback(spi_p->callback_ctx);
+                }
             }
         }
     }
@@ -54,15 +60,37 @@ void set_spi_dma_irq_channel(bool useChannel1, bool shared) {
     irqShared = shared;
 }
 
-// SPI Transfer: Read & Write (simultaneously) on SPI bus
-//   If the data that will be received is not important, pass NULL as rx.
-//   If the data that will be transmitted is not important,
-//     pass NULL as tx and then the SPI_FILL_CHAR is sent out as each data
-//     element.
-bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
-    // assert(512 == length || 1 == length);
+// Short transfers: feed the FIFO directly. For a command packet, a CRC
+// trailer or a poll byte this is cheaper than setting up two DMA channels and
+// waiting for their IRQ.
+static void spi_transfer_polled(spi_t *spi_p, const uint8_t *tx, uint8_t *rx,
+                                size_t length) {
+    if (tx && rx) {
+        spi_write_read_blocking(spi_p->hw_inst, tx, rx, length);
+    } else if (tx) {
+        spi_write_blocking(spi_p->hw_inst, tx, length);
+    } else {
+        spi_read_blocking(spi_p->hw_inst, SPI_FILL_CHAR, rx, length);
+    }
+}
+
+static bool spi_transfer_start(spi_t *spi_p, const uint8_t *tx, uint8_t *rx,
+                               size_t length, spi_callback_t callback, void *ctx,
+                               bool sniff) {
     assert(tx || rx);
-    // assert(!(tx && rx));
+    assert(!spi_p->pending);
+
+    // The sniffer watches the channel that carries the data: tx when a
+    // buffer is sent, otherwise rx
+    bool sniff_tx = sniff && tx;
+    bool sniff_rx = sniff && !tx;
+    channel_config_set_sniff_enable(&spi_p->tx_dma_cfg, sniff_tx);
+    channel_config_set_sniff_enable(&spi_p->rx_dma_cfg, sniff_rx);
+    if (sniff) {
+        dma_sniffer_enable(sniff_tx ? spi_p->tx_dma : spi_p->rx_dma,
+                           DMA_SNIFF_CTRL_CALC_VALUE_CRC16, false);
+        dma_hw->sniff_data = 0;  // CRC-16/XMODEM seed
+    }
 
     // tx write increment is already false
     if (tx) {
@@ -106,10 +134,51 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
             assert(false);
     }
     sem_reset(&spi_p->sem, 0);
+    spi_p->callback = callback;
+    spi_p->callback_ctx = ctx;
+    spi_p->pending = true;
+    spi_p->stats.dma_calls++;
+    spi_p->stats.dma_bytes += length;
 
     // start them exactly simultaneously to avoid races (in extreme cases
     // the FIFO could overflow)
     dma_start_channel_mask((1u << spi_p->tx_dma) | (1u << spi_p->rx_dma));
+    return true;
+}
+
+// Start a DMA transfer and return without waiting for it. The callback, if
+// any, runs in the DMA IRQ handler when the last byte has been received.
+// The buffers must stay valid until then, and spi_transfer_wait() must be
+// called before the next transfer on this SPI.
+bool spi_transfer_async(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length,
+                        spi_callback_t callback, void *ctx) {
+    return spi_transfer_start(spi_p, tx, rx, length, callback, ctx, false);
+}
+
+// As spi_transfer_async(), with the DMA sniffer computing CRC16-CCITT over
+// the data (tx if given, otherwise rx). Read it with spi_sniffed_crc16()
+// after spi_transfer_wait(). There is one sniffer, so only one such transfer
+// can run at a time across all SPIs.
+bool spi_transfer_async_crc16(spi_t *spi_p, const uint8_t *tx, uint8_t *rx,
+                              size_t length) {
+    return spi_transfer_start(spi_p, tx, rx, length, NULL, NULL, true);
+}
+
+uint16_t spi_sniffed_crc16(void) {
+    return (uint16_t)dma_hw->sniff_data;
+}
+
+// True while a transfer started by spi_transfer_async() is still running
+bool spi_transfer_busy(spi_t *spi_p) {
+    return spi_p->pending && !sem_available(&spi_p->sem);
+}
+
+// Complete the transfer started by spi_transfer_async()
+bool spi_transfer_wait(spi_t *spi_p) {
+    if (!spi_p->pending) {
+        return true;
+    }
+    spi_p->pending = false;
 
     /* Wait until master completes transfer or time out has occured. */
     uint32_t timeOut = 1000; /* Timeout 1 sec */
@@ -131,6 +200,44 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     return true;
 }
 
+// SPI Transfer: Read & Write (simultaneously) on SPI bus
+//   If the data that will be received is not important, pass NULL as rx.
+//   If the data that will be transmitted is not important,
+//     pass NULL as tx and then the SPI_FILL_CHAR is sent out as each data
+//     element.
+bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
+    assert(tx || rx);
+
+    uint32_t start = time_us_32();
+    if (length <= spi_p->polled_max) {
+        spi_transfer_polled(spi_p, tx, rx, length);
+        spi_p->stats.polled_us += time_us_32() - start;
+        spi_p->stats.polled_calls++;
+        spi_p->stats.polled_bytes += length;
+        return true;
+    }
+    bool rc = spi_transfer_async(spi_p, tx, rx, length, NULL, NULL) &&
+              spi_transfer_wait(spi_p);
+    spi_p->stats.dma_us += time_us_32() - start;
+    return rc;
+}
+
+// Takes effect on the next transfer; 0 sends everything through DMA
+void spi_set_polled_max(spi_t *spi_p, uint polled_max) {
+    spi_lock(spi_p);
+    spi_p->polled_max = polled_max;
+    spi_unlock(spi_p);
+}
+
+void spi_get_stats(spi_t *spi_p, spi_stats_t *stats, bool reset) {
+    spi_lock(spi_p);
+    *stats = spi_p->stats;
+    if (reset) {
+        memset(&spi_p->stats, 0, sizeof spi_p->stats);
+    }
+    spi_unlock(spi_p);
+}
+
 void spi_lock(spi_t *spi_p) {
     assert(mutex_is_initialized(&spi_p->mutex));
     mutex_enter_blocking(&spi_p->mutex);
@@ -153,6 +260,8 @@ bool my_spi_init(spi_t *spi_p) {
         // Default:
         if (!spi_p->baud_rate)
             spi_p->baud_rate = 10 * 1000 * 1000;
+        if (!spi_p->polled_max)
+            spi_p->polled_max = SPI_POLLED_MAX_DEFAULT;
         // For the IRQ notification:
         sem_init(&spi_p->sem, 0, 1);
 
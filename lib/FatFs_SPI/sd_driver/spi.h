@@ -27,6 +27,24 @@ specific language governing permissions and limitations under the License.
 
 #define SPI_FILL_CHAR (0xFF)
 
+// Default for spi_t.polled_max (see below)
+#ifndef SPI_POLLED_MAX_DEFAULT
+#define SPI_POLLED_MAX_DEFAULT 16
+#endif
+
+// Completion callback of spi_transfer_async(); runs in the DMA IRQ handler
+typedef void (*spi_callback_t)(void *ctx);
+
+// Per-path counters of spi_transfer(), for tuning polled_max on a real card
+typedef struct {
+    uint32_t polled_calls;
+    uint32_t polled_bytes;
+    uint64_t polled_us;
+    uint32_t dma_calls;
+    uint32_t dma_bytes;
+    uint64_t dma_us;    // Time callers were blocked; async overlap is not counted
+} spi_stats_t;
+
 // "Class" representing SPIs
 typedef struct {
     // SPI HW
@@ -44,6 +62,11 @@ typedef struct {
     enum gpio_drive_strength mosi_gpio_drive_strength;
     enum gpio_drive_strength sck_gpio_drive_strength;
 
+    // Transfers up to this many bytes poll the SPI FIFO instead of using DMA.
+    // 0 selects SPI_POLLED_MAX_DEFAULT; change at run time with
+    // spi_set_polled_max().
+    uint polled_max;
+
     // State variables:
     uint tx_dma;
     uint rx_dma;
@@ -53,6 +76,10 @@ typedef struct {
     bool initialized;  
     semaphore_t sem;
     mutex_t mutex;    
+    spi_stats_t stats;
+    volatile bool pending;           // Async transfer not yet waited for
+    volatile spi_callback_t callback;
+    void *callback_ctx;
 } spi_t;
 
 #ifdef __cplusplus
@@ -60,10 +87,18 @@ extern "C" {
 #endif
   
 bool __not_in_flash_func(spi_transfer)(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);  
+bool spi_transfer_async(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length,
+                        spi_callback_t callback, void *ctx);
+bool spi_transfer_async_crc16(spi_t *pSPI, const uint8_t *tx, uint8_t *rx, size_t length);
+uint16_t spi_sniffed_crc16(void);
+bool spi_transfer_busy(spi_t *pSPI);
+bool spi_transfer_wait(spi_t *pSPI);
 void spi_lock(spi_t *pSPI);
 void spi_unlock(spi_t *pSPI);
 bool my_spi_init(spi_t *pSPI);
 void set_spi_dma_irq_channel(bool useChannel1, bool shared);
+void spi_set_polled_max(spi_t *pSPI, uint polled_max);
+void spi_get_stats(spi_t *pSPI, spi_stats_t *stats, bool reset);
 
 #ifdef __cplusplus
 }
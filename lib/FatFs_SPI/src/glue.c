@@ -28,10 +28,41 @@ specific language governing permissions and limitations under the License.
 #include "hw_config.h"
 #include "my_debug.h"
 #include "sd_card.h"
+#include "sector_cache.h"
 
 #define TRACE_PRINTF(fmt, args...)
 //#define TRACE_PRINTF printf  // task_printf
 
+// Write-back sector cache in front of the first SD_SECTOR_CACHE_DRIVES drives
+#ifndef SD_SECTOR_CACHE
+#define SD_SECTOR_CACHE 1
+#endif
+#ifndef SD_SECTOR_CACHE_DRIVES
+#define SD_SECTOR_CACHE_DRIVES 1
+#endif
+
+#if SD_SECTOR_CACHE
+static sector_cache_t caches[SD_SECTOR_CACHE_DRIVES];
+
+static int cache_read(void *ctx, uint8_t *buffer, uint64_t sector, uint32_t count) {
+    sd_card_t *p_sd = ctx;
+    return p_sd->read_blocks(p_sd, buffer, sector, count);
+}
+
+static int cache_write(void *ctx, const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    sd_card_t *p_sd = ctx;
+    return p_sd->write_blocks(p_sd, buffer, sector, count);
+}
+#endif
+
+sector_cache_t *disk_get_cache(uint8_t pdrv) {
+#if SD_SECTOR_CACHE
+    if (pdrv < SD_SECTOR_CACHE_DRIVES) return &caches[pdrv];
+#endif
+    (void)pdrv;
+    return NULL;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Get Drive Status                                                      */
 /*-----------------------------------------------------------------------*/
@@ -59,8 +90,15 @@ DSTATUS disk_initialize(
 
     sd_card_t *p_sd = sd_get_by_num(pdrv);
     if (!p_sd) return RES_PARERR;
+    sector_cache_t *cache = disk_get_cache(pdrv);
+    if (cache && (p_sd->m_Status & STA_NOINIT)) {
+        // Nothing cached survives a (re)initialisation of the card. f_mkfs
+        // calls this on a live card too, which must keep its dirty sectors.
+        sector_cache_backend_t backend = {cache_read, cache_write, p_sd};
+        sector_cache_init(cache, &backend);
+    }
     // See http://elm-chan.org/fsw/ff/doc/dstat.html
-    return p_sd->init(p_sd);  
+    return p_sd->init(p_sd);
 }
 
 static int sdrc2dresult(int sd_rc) {
@@ -98,7 +136,9 @@ DRESULT disk_read(BYTE pdrv,  /* Physical drive nmuber to identify the drive */
     TRACE_PRINTF(">>> %s\n", __FUNCTION__);
     sd_card_t *p_sd = sd_get_by_num(pdrv);
     if (!p_sd) return RES_PARERR;
-    int rc = p_sd->read_blocks(p_sd, buff, sector, count);
+    sector_cache_t *cache = disk_get_cache(pdrv);
+    int rc = cache ? sector_cache_read(cache, buff, sector, count)
+                   : p_sd->read_blocks(p_sd, buff, sector, count);
     return sdrc2dresult(rc);
 }
 
@@ -116,7 +156,9 @@ DRESULT disk_write(BYTE pdrv, /* Physical drive nmuber to identify the drive */
     TRACE_PRINTF(">>> %s\n", __FUNCTION__);
     sd_card_t *p_sd = sd_get_by_num(pdrv);
     if (!p_sd) return RES_PARERR;
-    int rc = p_sd->write_blocks(p_sd, buff, sector, count);
+    sector_cache_t *cache = disk_get_cache(pdrv);
+    int rc = cache ? sector_cache_write(cache, buff, sector, count)
+                   : p_sd->write_blocks(p_sd, buff, sector, count);
     return sdrc2dresult(rc);
 }
 
@@ -156,12 +198,29 @@ DRESULT disk_ioctl(BYTE pdrv, /* Physical drive nmuber (0..) */
                                 // f_mkfs function and it attempts to align data
                                 // area on the erase block boundary. It is
                                 // required when FF_USE_MKFS == 1.
-            static DWORD bs = 1;
-            *(DWORD *)buff = bs;
+            // The card's allocation unit, read from its SD Status at init
+            *(DWORD *)buff = p_sd->au_sectors ? p_sd->au_sectors : 1;
             return RES_OK;
         }
-        case CTRL_SYNC:
-            return RES_OK;
+        case CTRL_SYNC: {  // Completes pending write process. Dirty cached
+                           // sectors are written back, an open multi-block
+                           // write session is ended and its status checked,
+                           // and the card is left to finish programming
+                           // before FatFs goes on.
+            sector_cache_t *cache = disk_get_cache(pdrv);
+            int rc = cache ? sector_cache_flush(cache) : SD_BLOCK_DEVICE_ERROR_NONE;
+            if (rc == SD_BLOCK_DEVICE_ERROR_NONE) rc = sd_sync(p_sd);
+            return sdrc2dresult(rc);
+        }
+        case CTRL_TRIM: {  // Informs the device that the data on the block of
+                           // sectors, an LBA_t array {start, end} pointed by
+                           // buff, is no longer needed. Required when
+                           // FF_USE_TRIM == 1.
+            LBA_t *range = (LBA_t *)buff;
+            sector_cache_t *cache = disk_get_cache(pdrv);
+            if (cache) sector_cache_discard(cache, range[0], range[1] - range[0] + 1);
+            return sdrc2dresult(sd_trim(p_sd, range[0], range[1]));
+        }
         default:
             return RES_PARERR;
     }
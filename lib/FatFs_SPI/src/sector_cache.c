@@ -0,0 +1,192 @@
+/**
+ * @file sector_cache.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Write-back sector cache between FatFs and a block device
+ *
+ * A lookup is a linear scan: with 8-32 entries that is cheaper than keeping
+ * any index structure up to date. Writes to sectors that are not cached do not
+ * read the device first, since FatFs always writes whole sectors.
+ */
+
+#include <string.h>
+#include "sector_cache.h"
+
+#define SS SECTOR_CACHE_SECTOR_SIZE
+
+static int lookup(const sector_cache_t *cache, uint64_t sector) {
+    for (int i = 0; i < SECTOR_CACHE_SECTORS; i++) {
+        if (cache->entries[i].valid && cache->entries[i].sector == sector) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void touch(sector_cache_t *cache, int i) {
+    cache->entries[i].last_use = ++cache->clock;
+}
+
+void sector_cache_init(sector_cache_t *cache, const sector_cache_backend_t *backend) {
+    memset(cache->entries, 0, sizeof(cache->entries));
+    memset(&cache->stats, 0, sizeof(cache->stats));
+    cache->clock = 0;
+    cache->backend = *backend;
+}
+
+// === Write back dirty sectors in sector order, merging adjacent ones ===
+int sector_cache_flush(sector_cache_t *cache) {
+    uint8_t order[SECTOR_CACHE_SECTORS];
+    int n = 0;
+
+    // Insertion sort of the dirty entries by sector
+    for (int i = 0; i < SECTOR_CACHE_SECTORS; i++) {
+        const sector_cache_entry_t *e = &cache->entries[i];
+        if (!e->valid || !e->dirty) {
+            continue;
+        }
+        int j = n++;
+        while (j > 0 && cache->entries[order[j - 1]].sector > e->sector) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = (uint8_t)i;
+    }
+
+    for (int i = 0; i < n;) {
+        uint64_t first = cache->entries[order[i]].sector;
+        int run = 1;
+        while (i + run < n && run < SECTOR_CACHE_COALESCE &&
+               cache->entries[order[i + run]].sector == first + run) {
+            run++;
+        }
+
+        const uint8_t *src = cache->data[order[i]];
+        if (run > 1) {
+            for (int k = 0; k < run; k++) {
+                memcpy(&cache->staging[k * SS], cache->data[order[i + k]], SS);
+            }
+            src = cache->staging;
+        }
+        int status = cache->backend.write(cache->backend.ctx, src, first, run);
+        if (status != 0) {
+            return status;  // Still dirty; a later flush retries
+        }
+
+        for (int k = 0; k < run; k++) {
+            cache->entries[order[i + k]].dirty = false;
+        }
+        cache->stats.writebacks++;
+        cache->stats.written_back += run;
+        i += run;
+    }
+    return 0;
+}
+
+// === Free slot, or the least recently used one (written back if dirty) ===
+static int claim_slot(sector_cache_t *cache, int *status) {
+    int lru = -1;
+    for (int i = 0; i < SECTOR_CACHE_SECTORS; i++) {
+        if (!cache->entries[i].valid) {
+            return i;
+        }
+        if (lru < 0 || cache->entries[i].last_use < cache->entries[lru].last_use) {
+            lru = i;
+        }
+    }
+
+    // Writing every dirty sector now, not just the victim, gives the
+    // write-back longer runs to merge
+    if (cache->entries[lru].dirty) {
+        *status = sector_cache_flush(cache);
+        if (*status != 0) {
+            return -1;
+        }
+    }
+    cache->entries[lru].valid = false;
+    cache->stats.evictions++;
+    return lru;
+}
+
+int sector_cache_read(sector_cache_t *cache, uint8_t *buffer, uint64_t sector, uint32_t count) {
+    if (count >= SECTOR_CACHE_BYPASS) {
+        int status = cache->backend.read(cache->backend.ctx, buffer, sector, count);
+        if (status != 0) {
+            return status;
+        }
+        // Dirty copies are newer than what the device returned
+        for (int i = 0; i < SECTOR_CACHE_SECTORS; i++) {
+            const sector_cache_entry_t *e = &cache->entries[i];
+            if (e->valid && e->dirty && e->sector >= sector && e->sector < sector + count) {
+                memcpy(&buffer[(e->sector - sector) * SS], cache->data[i], SS);
+            }
+        }
+        cache->stats.bypassed += count;
+        return 0;
+    }
+
+    for (uint32_t k = 0; k < count; k++, buffer += SS) {
+        int i = lookup(cache, sector + k);
+        if (i >= 0) {
+            cache->stats.hits++;
+        } else {
+            int status = 0;
+            i = claim_slot(cache, &status);
+            if (i < 0) {
+                return status;
+            }
+            status = cache->backend.read(cache->backend.ctx, cache->data[i], sector + k, 1);
+            if (status != 0) {
+                return status;
+            }
+            cache->entries[i].sector = sector + k;
+            cache->entries[i].valid = true;
+            cache->entries[i].dirty = false;
+            cache->stats.misses++;
+        }
+        memcpy(buffer, cache->data[i], SS);
+        touch(cache, i);
+    }
+    return 0;
+}
+
+int sector_cache_write(sector_cache_t *cache, const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    if (count >= SECTOR_CACHE_BYPASS) {
+        // Cached copies in the range are superseded, dirty or not
+        sector_cache_discard(cache, sector, count);
+        cache->stats.bypassed += count;
+        return cache->backend.write(cache->backend.ctx, buffer, sector, count);
+    }
+
+    for (uint32_t k = 0; k < count; k++, buffer += SS) {
+        int i = lookup(cache, sector + k);
+        if (i < 0) {
+            int status = 0;
+            i = claim_slot(cache, &status);
+            if (i < 0) {
+                return status;
+            }
+            cache->entries[i].sector = sector + k;
+            cache->entries[i].valid = true;
+        }
+        memcpy(cache->data[i], buffer, SS);
+        cache->entries[i].dirty = true;
+        touch(cache, i);
+    }
+    return 0;
+}
+
+// === Forget cached sectors that were rewritten behind the cache's back ===
+void sector_cache_discard(sector_cache_t *cache, uint64_t sector, uint64_t count) {
+    for (int i = 0; i < SECTOR_CACHE_SECTORS; i++) {
+        sector_cache_entry_t *e = &cache->entries[i];
+        if (e->valid && e->sector >= sector && e->sector < sector + count) {
+            e->valid = false;
+            e->dirty = false;
+        }
+    }
+}
+
+void sector_cache_get_stats(const sector_cache_t *cache, sector_cache_stats_t *stats) {
+    *stats = cache->stats;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file log_file.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Log file open/close with a pre-allocated cluster reservation
+ *
+ * The reservation works by lowering obj.objsize back to the real size after
+ * the chain has been extended. On FAT, f_write at a cluster boundary calls
+ * create_chain(), which follows an existing link before allocating, so the
+ * reserved clusters are reused in order. To release the tail, objsize is
+ * raised above the real size again so that f_truncate() frees the rest of
+ * the chain. exFAT allocates through its bitmap instead and already keeps
+ * contiguous files without FAT updates, so no reservation is made there.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "log_file.h"
+
+static FSIZE_t reserved_end = 0;   // File offset the chain is reserved up to, 0 if none
+// Marker and recovery handle. Static: a FIL holds a 512-byte sector buffer and
+// core1 runs FatFs on a small stack. Only one of them is ever open at a time.
+static FIL work_file;
+
+// === Free the chain beyond the real file size ===
+static FRESULT release_tail(FIL *fp, FSIZE_t end) {
+    FSIZE_t size = f_size(fp);
+    if (end <= size) {
+        return FR_OK;
+    }
+
+    // Any objsize above the real size makes f_truncate drop the rest of the chain
+    fp->obj.objsize = end;
+    FRESULT fr = f_lseek(fp, size);
+    if (fr == FR_OK) {
+        fr = f_truncate(fp);
+    }
+    if (fr != FR_OK) {
+        fp->obj.objsize = size;  // Never let the reserved size reach the directory entry
+    }
+    return fr;
+}
+
+// === Release a reservation left by a session that did not close cleanly ===
+static FRESULT recover(const char *path) {
+    FIL *marker = &work_file;
+    FRESULT fr = f_open(marker, LOG_FILE_MARKER, FA_READ);
+    if (fr == FR_NO_FILE) {
+        return FR_OK;
+    }
+    if (fr != FR_OK) {
+        return fr;
+    }
+
+    FSIZE_t end = 0;
+    UINT br;
+    fr = f_read(marker, &end, sizeof(end), &br);
+    f_close(marker);
+
+    if (fr == FR_OK && br == sizeof(end)) {
+        FIL *log = &work_file;      // The marker is closed: reuse its handle
+        fr = f_open(log, path, FA_WRITE | FA_OPEN_EXISTING);
+        if (fr == FR_OK) {
+            FSIZE_t size = f_size(log);
+            fr = release_tail(log, end);
+            FRESULT fr_close = f_close(log);
+            if (fr == FR_OK) {
+                fr = fr_close;
+            }
+            if (fr == FR_OK && end > size) {
+                printf("Log file: released %lu reserved bytes after unclean shutdown\n",
+                       (uint32_t)(end - size));
+            }
+        } else if (fr == FR_NO_FILE) {
+            fr = FR_OK;
+        }
+    }
+    return (fr == FR_OK) ? f_unlink(LOG_FILE_MARKER) : fr;
+}
+
+static FRESULT write_marker(FSIZE_t end) {
+    FIL *marker = &work_file;
+    FRESULT fr = f_open(marker, LOG_FILE_MARKER, FA_WRITE | FA_CREATE_ALWAYS);
+    if (fr != FR_OK) {
+        return fr;
+    }
+    UINT bw;
+    fr = f_write(marker, &end, sizeof(end), &bw);
+    FRESULT fr_close = f_close(marker);
+    if (fr == FR_OK && bw != sizeof(end)) {
+        fr = FR_DISK_ERR;
+    }
+    return (fr == FR_OK) ? fr_close : fr;
+}
+
+// === Extend the chain to size + bytes and keep the real size ===
+static FRESULT reserve(FIL *fp, FSIZE_t bytes) {
+    FSIZE_t size = f_size(fp);
+    FSIZE_t end = size + bytes;
+    bool contiguous = false;
+
+    // Recorded first, so an interruption at any later point is recoverable
+    FRESULT fr = write_marker(end);
+    if (fr != FR_OK) {
+        return fr;
+    }
+
+    // A new file gets one contiguous block; otherwise extend the existing chain
+    if (size == 0 && f_expand(fp, end, 1) == FR_OK) {
+        contiguous = true;
+    } else {
+        fr = f_lseek(fp, end);
+    }
+
+    FSIZE_t allocated = f_size(fp);  // Short of end if the card is full
+    fp->obj.objsize = size;
+    FRESULT fr_seek = f_lseek(fp, size);
+    if (fr == FR_OK) {
+        fr = fr_seek;
+    }
+    if (fr == FR_OK) {
+        fr = f_sync(fp);
+    }
+    if (fr == FR_OK) {
+        reserved_end = end;
+        printf("Log file: reserved %lu bytes (%s)\n", (uint32_t)(allocated - size),
+               contiguous ? "contiguous" : "chained");
+    }
+    return fr;
+}
+
+// === Open for append, recovering and reserving as needed ===
+FRESULT log_file_open(FIL *fp, const char *path, FSIZE_t reserve_bytes) {
+    reserved_end = 0;
+
+    FRESULT fr = recover(path);
+    if (fr != FR_OK) {
+        return fr;
+    }
+
+    fr = f_open(fp, path, FA_WRITE | FA_OPEN_APPEND);
+    if (fr != FR_OK || reserve_bytes == 0) {
+        return fr;
+    }
+#if FF_FS_EXFAT
+    if (fp->obj.fs->fs_type == FS_EXFAT) {
+        return FR_OK;
+    }
+#endif
+
+    // Running without a reservation is still a working log
+    if (reserve(fp, reserve_bytes) != FR_OK) {
+        printf("WARNING: Log file pre-allocation failed, growing on demand\n");
+    }
+    return FR_OK;
+}
+
+// === Trim the file to its real size and close it ===
+FRESULT log_file_close(FIL *fp) {
+    FRESULT fr = release_tail(fp, reserved_end);
+    FRESULT fr_close = f_close(fp);
+    if (fr == FR_OK) {
+        fr = fr_close;
+    }
+    if (fr == FR_OK && reserved_end != 0) {
+        fr = f_unlink(LOG_FILE_MARKER);
+        reserved_end = 0;
+    }
+    return fr;
+}
+
+FSIZE_t log_file_reserved_end(void) {
+    return reserved_end;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file log_file.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Log file open/close with a pre-allocated cluster reservation
+ *
+ * On open, the cluster chain is extended ahead of the data (contiguously with
+ * f_expand for a new file), while the directory entry keeps the real size.
+ * Appends then follow the existing chain instead of allocating a cluster and
+ * updating the FAT/FSINFO every few kilobytes. The unused tail is released on
+ * a clean close, or at the next open if the session ended without one; a
+ * small marker file records that a reservation is outstanding.
+ */
+
+#ifndef LOG_FILE_H
+#define LOG_FILE_H
+
+#include "ff.h"
+
+// Marker holding the reserved end offset while a reservation is outstanding
+#ifndef LOG_FILE_MARKER
+#define LOG_FILE_MARKER     "logalloc.dat"
+#endif
+
+FRESULT log_file_open(FIL *fp, const char *path, FSIZE_t reserve_bytes);
+FRESULT log_file_close(FIL *fp);
+FSIZE_t log_file_reserved_end(void);
+
+#endif // LOG_FILE_H
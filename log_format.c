@@ -0,0 +1,86 @@
+/**
+ * @file log_format.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Compact binary log record format
+ */
+
+#include <string.h>
+#include "log_format.h"
+
+static uint64_t last_timestamp_us = 0;  // Base of the next delta
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_record(uint8_t *p, uint32_t delta, uint8_t id, uint32_t value) {
+    put_u32(p, delta);
+    put_u32(p + 4, id | ((value & LOG_RECORD_VALUE_MASK) << 8));
+}
+
+// Absolute timestamp record; also resets the delta base
+static size_t put_absolute(uint8_t *p, uint8_t id, uint64_t timestamp_us) {
+    put_record(p, (uint32_t)timestamp_us, id, (uint32_t)(timestamp_us >> 32));
+    last_timestamp_us = timestamp_us;
+    return LOG_RECORD_SIZE;
+}
+
+// === File header with the event-name dictionary; 0 if it does not fit ===
+// Padded to a whole sector, so every record is 8-byte aligned and no record
+// straddles a sector.
+size_t log_format_header(uint8_t *buf, size_t size) {
+    size_t len = 4 + 2 + 2 + 1;
+    for (uint8_t id = EVENT_NONE + 1; id < EVENT_COUNT; id++) {
+        len += 2 + strlen(event_name(id));
+    }
+    if (len > LOG_FORMAT_HEADER_SIZE || size < LOG_FORMAT_HEADER_SIZE) {
+        return 0;
+    }
+
+    memset(buf, 0, LOG_FORMAT_HEADER_SIZE);
+    memcpy(buf, LOG_FORMAT_MAGIC, 4);
+    put_u16(buf + 4, LOG_FORMAT_VERSION);
+    put_u16(buf + 6, LOG_FORMAT_HEADER_SIZE);
+    buf[8] = EVENT_COUNT - 1;
+
+    uint8_t *p = buf + 9;
+    for (uint8_t id = EVENT_NONE + 1; id < EVENT_COUNT; id++) {
+        const char *name = event_name(id);
+        size_t name_len = strlen(name);
+        p[0] = id;
+        p[1] = (uint8_t)name_len;
+        memcpy(p + 2, name, name_len);
+        p += 2 + name_len;
+    }
+    return LOG_FORMAT_HEADER_SIZE;
+}
+
+// === Session start: one per boot, before the first event ===
+size_t log_format_session(uint8_t *buf, uint64_t timestamp_us) {
+    return put_absolute(buf, LOG_RECORD_SESSION, timestamp_us);
+}
+
+// === Encode one event, preceded by a time record if the delta overflows ===
+size_t log_format_record(uint8_t *buf, const event_t *event) {
+    size_t len = 0;
+    int64_t delta = (int64_t)(event->timestamp_us - last_timestamp_us);
+
+    if (delta < INT32_MIN || delta > INT32_MAX) {
+        len += put_absolute(buf, LOG_RECORD_TIME, event->timestamp_us);
+        delta = 0;
+    }
+
+    // Deltas may be negative: button presses carry their edge time
+    put_record(buf + len, (uint32_t)(int32_t)delta, event->id, event->payload);
+    last_timestamp_us = event->timestamp_us;
+    return len + LOG_RECORD_SIZE;
+}
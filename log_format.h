@@ -0,0 +1,45 @@
+/**
+ * @file log_format.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Compact binary log record format
+ *
+ * File layout (all fields little endian):
+ *
+ *   Header   "BDLG", uint16 version, uint16 header length, uint8 entry count,
+ *            then per entry: uint8 id, uint8 name length, name bytes, zero
+ *            padded to LOG_FORMAT_HEADER_SIZE (readers skip to header length)
+ *   Records  8 bytes each: int32 delta_us, uint32 (id | value << 8)
+ *
+ * delta_us is relative to the previous record's timestamp. Two reserved ids
+ * carry an absolute 56-bit timestamp split over both fields (low 32 bits in
+ * the delta field, high 24 bits in the value field): LOG_RECORD_SESSION marks
+ * a new boot appended to an existing file, LOG_RECORD_TIME resynchronises
+ * the delta base when a gap does not fit in 32 bits.
+ */
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "event_queue.h"
+
+#define LOG_FORMAT_MAGIC        "BDLG"
+#define LOG_FORMAT_VERSION      1
+#define LOG_RECORD_SIZE         8
+#define LOG_FORMAT_HEADER_SIZE  512     // One sector: records start sector aligned
+#define LOG_RECORD_VALUE_MASK   0x00FFFFFFu
+
+// Reserved record ids (never used by event_id_t)
+#define LOG_RECORD_SESSION      0xFE
+#define LOG_RECORD_TIME         0xFF
+
+// Largest output of log_format_record(): a time record plus the event record
+#define LOG_RECORD_MAX          (2 * LOG_RECORD_SIZE)
+
+size_t log_format_header(uint8_t *buf, size_t size);
+size_t log_format_session(uint8_t *buf, uint64_t timestamp_us);
+size_t log_format_record(uint8_t *buf, const event_t *event);
+
+#endif // LOG_FORMAT_H
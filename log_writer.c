@@ -0,0 +1,220 @@
+/**
+ * @file log_writer.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Group-commit log writer for the BitDogLab Datalogger
+ *
+ * The ring is indexed by absolute byte counters whose value modulo the sector
+ * size matches the file offset modulo the sector size. A flush that ends on a
+ * counter multiple of 512 therefore ends on a file sector boundary as well, and
+ * FatFs passes those sectors straight to disk_write() without copying them
+ * through its own sector buffer.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "log_writer.h"
+
+#if (LOG_WRITER_RING_SIZE % LOG_WRITER_SECTOR_SIZE) != 0
+#error "LOG_WRITER_RING_SIZE must be a multiple of the sector size"
+#endif
+
+// === Module State ===
+static FIL *log_file = NULL;
+static log_writer_config_t log_config;
+static log_writer_stats_t log_stats;
+
+static uint8_t ring[LOG_WRITER_RING_SIZE] __attribute__((aligned(4)));
+static uint32_t ring_wr = 0;        // Bytes accepted (absolute counter)
+static uint32_t ring_rd = 0;        // Bytes handed to FatFs (absolute counter)
+static uint32_t oldest_ms = 0;      // Arrival time of the oldest unflushed byte
+static uint32_t last_sync_ms = 0;
+static bool sync_pending = false;   // Data written since the last f_sync
+
+static inline uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void record_error(FRESULT fr) {
+    log_stats.errors++;
+    log_stats.last_error = fr;
+    printf("ERROR: Log writer FatFs error %d\n", fr);
+}
+
+// === Write ring bytes [ring_rd, end) to the file ===
+static bool flush_until(uint32_t end) {
+    if (end == ring_rd) {
+        return true;
+    }
+
+    uint32_t start_us = time_us_32();
+    while (ring_rd != end) {
+        uint32_t pos = ring_rd % LOG_WRITER_RING_SIZE;
+        uint32_t len = end - ring_rd;
+        if (len > LOG_WRITER_RING_SIZE - pos) {
+            len = LOG_WRITER_RING_SIZE - pos;  // Stop at the wrap point
+        }
+
+        UINT written;
+        FRESULT fr = f_write(log_file, &ring[pos], len, &written);
+        if (fr != FR_OK || written != len) {
+            // The part that did reach the file must not be written again
+            ring_rd += written;
+            if (written > 0) {
+                sync_pending = true;
+            }
+            record_error(fr != FR_OK ? fr : FR_DENIED);
+            return false;
+        }
+        ring_rd += len;
+    }
+
+    uint32_t elapsed = time_us_32() - start_us;
+    log_stats.flushes++;
+    log_stats.flush_time_us += elapsed;
+    if (elapsed > log_stats.max_flush_us) {
+        log_stats.max_flush_us = elapsed;
+    }
+    oldest_ms = now_ms();
+    sync_pending = true;
+    return true;
+}
+
+static bool sync_file(void) {
+    uint32_t start_us = time_us_32();
+    FRESULT fr = f_sync(log_file);
+    if (fr != FR_OK) {
+        record_error(fr);
+        return false;
+    }
+
+    uint32_t elapsed = time_us_32() - start_us;
+    log_stats.syncs++;
+    log_stats.sync_time_us += elapsed;
+    if (elapsed > log_stats.max_sync_us) {
+        log_stats.max_sync_us = elapsed;
+    }
+    last_sync_ms = now_ms();
+    sync_pending = false;
+    return true;
+}
+
+// === Attach the writer to an open file ===
+bool log_writer_init(FIL *file, const log_writer_config_t *config) {
+    if (file == NULL || config == NULL) {
+        return false;
+    }
+
+    log_file = file;
+    log_config = *config;
+    memset(&log_stats, 0, sizeof(log_stats));
+    log_stats.last_error = FR_OK;
+    log_stats.started_ms = now_ms();
+
+    // Align the ring with the file so whole-sector flushes stay sector aligned
+    ring_wr = ring_rd = (uint32_t)(f_tell(file) % LOG_WRITER_SECTOR_SIZE);
+    oldest_ms = last_sync_ms = log_stats.started_ms;
+    sync_pending = false;
+    return true;
+}
+
+// === Queue one record; flushes whole sectors when the size threshold is hit ===
+bool log_writer_append(const void *data, size_t len) {
+    if (log_file == NULL) {
+        return false;
+    }
+    if (len > LOG_WRITER_RING_SIZE) {
+        return false;
+    }
+
+    // Ring full: drain it synchronously rather than dropping the record
+    if (len > LOG_WRITER_RING_SIZE - (ring_wr - ring_rd)) {
+        log_stats.forced_flushes++;
+        if (!flush_until(ring_wr)) {
+            return false;
+        }
+    }
+
+    if (ring_wr == ring_rd) {
+        oldest_ms = now_ms();
+    }
+
+    const uint8_t *src = data;
+    size_t remaining = len;
+    while (remaining > 0) {
+        uint32_t pos = ring_wr % LOG_WRITER_RING_SIZE;
+        size_t chunk = LOG_WRITER_RING_SIZE - pos;
+        if (chunk > remaining) {
+            chunk = remaining;
+        }
+        memcpy(&ring[pos], src, chunk);
+        src += chunk;
+        remaining -= chunk;
+        ring_wr += chunk;
+    }
+
+    log_stats.records++;
+    log_stats.bytes += len;
+
+    if (ring_wr - ring_rd >= log_config.flush_bytes) {
+        // Hand over whole sectors only; the partial tail waits for more data
+        uint32_t end = ring_wr - (ring_wr % LOG_WRITER_SECTOR_SIZE);
+        if (end > ring_rd && !flush_until(end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// === Periodic service: age-based flush and metadata sync cadence ===
+bool log_writer_poll(void) {
+    if (log_file == NULL) {
+        return false;
+    }
+
+    uint32_t now = now_ms();
+    bool ok = true;
+
+    if (ring_wr != ring_rd && (now - oldest_ms) >= log_config.flush_age_ms) {
+        ok = flush_until(ring_wr);
+    }
+    if (ok && sync_pending && (now - last_sync_ms) >= log_config.sync_interval_ms) {
+        ok = sync_file();
+    }
+    return ok;
+}
+
+// === Flush everything buffered, optionally followed by f_sync ===
+bool log_writer_flush(bool sync) {
+    if (log_file == NULL) {
+        return false;
+    }
+    if (!flush_until(ring_wr)) {
+        return false;
+    }
+    return sync ? sync_file() : true;
+}
+
+size_t log_writer_pending(void) {
+    return ring_wr - ring_rd;
+}
+
+void log_writer_get_stats(log_writer_stats_t *stats) {
+    *stats = log_stats;
+}
+
+// === Print throughput figures over the serial console ===
+void log_writer_print_stats(void) {
+    uint32_t elapsed_ms = now_ms() - log_stats.started_ms;
+    uint32_t rate_milli = elapsed_ms ? (uint32_t)((uint64_t)log_stats.records * 1000000 / elapsed_ms) : 0;
+
+    printf("Log: %lu events (%lu.%03lu ev/s), %lu bytes, %lu flushes (%lu forced), %lu syncs\n",
+           log_stats.records, rate_milli / 1000, rate_milli % 1000, log_stats.bytes,
+           log_stats.flushes, log_stats.forced_flushes, log_stats.syncs);
+    printf("Log: flush avg %lu us / max %lu us, sync avg %lu us / max %lu us, errors %lu\n",
+           log_stats.flushes ? (uint32_t)(log_stats.flush_time_us / log_stats.flushes) : 0,
+           log_stats.max_flush_us,
+           log_stats.syncs ? (uint32_t)(log_stats.sync_time_us / log_stats.syncs) : 0,
+           log_stats.max_sync_us, log_stats.errors);
+}
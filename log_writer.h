@@ -0,0 +1,61 @@
+/**
+ * @file log_writer.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Group-commit log writer for the BitDogLab Datalogger
+ *
+ * Records are appended to a RAM ring and handed to FatFs in whole sectors
+ * once a size or age threshold is reached. Directory/FAT metadata is synced
+ * on a separate, slower cadence, so a single event no longer costs a full
+ * f_sync round trip on the card.
+ */
+
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "ff.h"
+
+// === Build-time Configuration ===
+// Ring capacity in bytes. Must be a multiple of the sector size (512) so that
+// whole-sector flushes never straddle the wrap point.
+#ifndef LOG_WRITER_RING_SIZE
+#define LOG_WRITER_RING_SIZE    8192
+#endif
+
+#define LOG_WRITER_SECTOR_SIZE  512
+
+// === Runtime Configuration ===
+typedef struct {
+    uint32_t flush_bytes;       // Flush whole sectors once this many bytes are buffered
+    uint32_t flush_age_ms;      // Flush everything once the oldest byte is this old
+    uint32_t sync_interval_ms;  // Minimum time between f_sync calls (metadata cadence)
+} log_writer_config_t;
+
+// === Statistics ===
+typedef struct {
+    uint32_t records;           // Calls to log_writer_append()
+    uint32_t bytes;             // Bytes accepted into the ring
+    uint32_t flushes;           // Flushes handed to f_write
+    uint32_t forced_flushes;    // Flushes caused by a full ring
+    uint32_t syncs;             // f_sync calls
+    uint32_t errors;            // FatFs errors seen
+    uint32_t max_flush_us;      // Slowest single flush
+    uint32_t max_sync_us;       // Slowest single sync
+    uint64_t flush_time_us;     // Total time spent in f_write
+    uint64_t sync_time_us;      // Total time spent in f_sync
+    uint32_t started_ms;        // Time of log_writer_init()
+    FRESULT last_error;         // Most recent FatFs error (FR_OK if none)
+} log_writer_stats_t;
+
+bool log_writer_init(FIL *file, const log_writer_config_t *config);
+bool log_writer_append(const void *data, size_t len);
+bool log_writer_poll(void);
+bool log_writer_flush(bool sync);
+size_t log_writer_pending(void);
+void log_writer_get_stats(log_writer_stats_t *stats);
+void log_writer_print_stats(void);
+
+#endif // LOG_WRITER_H
@@ -12,13 +12,26 @@
 #include <string.h>
 #include <stdbool.h>
 #include "pico/stdlib.h"
+#include "pico/multicore.h"
 #include "hardware/adc.h"
 #include "hardware/spi.h"
 #include "hardware/i2c.h"
+#include "hardware/sync.h"
 #include "ff.h"
 #include "diskio.h"
+#include "hw_config.h"
 #include "inc/ssd1306.h"
 #include "inc/ssd1306_fonts.h"
+#include "log_writer.h"
+#include "log_format.h"
+#include "log_file.h"
+#include "event_queue.h"
+#include "actuators.h"
+#include "button_capture.h"
+#include "joystick_dma.h"
+#include "stream_capture.h"
+#include "sector_cache.h"
+#include "sd_format.h"
 
 // === Pin Definitions ===
 #define RED_LED      13
@@ -30,37 +43,99 @@
 #define JOY_X        26  // ADC0
 #define JOY_Y        27  // ADC1
 
-#define PIN_MISO     16
-#define PIN_MOSI     19
-#define PIN_SCK      18
-#define PIN_CS       17
-
 #define SDA_I2C      8
 #define SCL_I2C      9
 #define I2C_PORT     i2c0
 
+// 1: fixed 8-byte binary records (see log_format.h), decoded on the host
+// 0: CSV text
+#ifndef LOG_FORMAT_BINARY
+#define LOG_FORMAT_BINARY   0
+#endif
+
 // === Configuration Constants ===
-#define SPI_BAUDRATE        1000000  // 1 MHz
 #define I2C_BAUDRATE        100000   // 100 kHz
+#if LOG_FORMAT_BINARY
+#define LOG_FILENAME        "bitdoglab.bin"
+#else
 #define LOG_FILENAME        "bitdoglab.txt"
+#endif
 #define DEBOUNCE_MS         50       // Button debounce time
 #define LED_DURATION_MS     300      // LED on duration
-#define LOOP_DELAY_MS       50       // Main loop delay
+#define LOOP_DELAY_MS       10       // Main loop delay (button edges are captured by IRQ)
 #define JOY_MIN_THRESHOLD   1000     // Joystick minimum threshold
 #define JOY_MAX_THRESHOLD   3000     // Joystick maximum threshold
 #define ADC_MAX_VALUE       4095     // 12-bit ADC
+#define LOG_FLUSH_BYTES     4096     // Flush to the card once this much is buffered
+#define LOG_FLUSH_AGE_MS    250      // ...or once the oldest buffered event is this old
+#define LOG_SYNC_INTERVAL_MS 1000    // f_sync (FAT/directory update) cadence
+#define LOG_PREALLOC_BYTES  (4u * 1024 * 1024)  // Clusters reserved ahead of the log (0: off)
+#define STATS_INTERVAL_MS   10000    // Log writer statistics report interval
+#define SINK_IDLE_WAIT_MS   10       // Longest core1 sleep between sink passes
+#define JOY_FRAME_RATE_HZ   1000     // Free-running joystick frames (x, y) per second
+#define JOY_LOG_INTERVAL_MS 20       // Joystick trajectory period (mean of the frames)
+#define CAPTURE_FRAME_RATE_HZ 10000  // Joystick frame rate during a raw capture
+#define CAPTURE_DURATION_MS 10000    // Raw capture length
+#define CAPTURE_COPY_FRAMES 512      // Frames moved from the ADC ring per copy
+#define FORMAT_CONFIRM_MS   5000     // Second 'F' must follow the first within this
+#define FORMAT_HOLD_MS      5000     // A+B must stay held this long at power-up to format
+#define FORMAT_BENCH_BYTES  (4u * 1024 * 1024)  // Sequential write benchmark after a format
+#define FORMAT_BENCH_FILE   "bench.tmp"
+#define WRITE_BENCH_BYTES   (1u * 1024 * 1024)  // Per write size, for the 'b' command
+#define GLYPH_BENCH_GLYPHS  2000     // Glyphs per row, for the 'g' command
+
+// 1: core0 samples inputs, core1 owns FatFs, the SD driver and the OLED.
+// 0: everything runs on core0 (sink called from the main loop).
+#ifndef DUAL_CORE_MODE
+#define DUAL_CORE_MODE      1
+#endif
+
+// 1: ADC free-runs in round-robin into a DMA ring and the joystick trajectory
+//    is logged as JOYSTICK_POS samples.
+// 0: two blocking adc_read() calls per loop, threshold events only.
+#ifndef JOYSTICK_DMA_MODE
+#define JOYSTICK_DMA_MODE   1
+#endif
+
+// Also sample the internal temperature sensor (ADC4) in the DMA round-robin
+#ifndef JOY_SAMPLE_TEMP
+#define JOY_SAMPLE_TEMP     0
+#endif
 
 // === Global Variables ===
 FATFS fs;
 FIL file;
-bool sd_card_ready = false;
+volatile bool sd_card_ready = false;  // Written by the sink, read by both cores
 
-// Button state tracking for debounce
-static uint32_t last_button_time_a = 0;
-static uint32_t last_button_time_b = 0;
+// Joystick throttling and statistics timing
 static uint32_t last_joystick_time = 0;
-static bool last_button_a_state = false;
-static bool last_button_b_state = false;
+static uint32_t last_joystick_log_time = 0;
+static uint32_t last_stats_time = 0;
+
+// Sampling path -> SD/OLED sink
+static event_queue_t event_queue;
+
+// A frame was drawn while the previous one was still going out over I2C
+static bool display_pending = false;
+
+#if JOYSTICK_DMA_MODE
+// Raw capture state (sink side)
+static joystick_reader_t capture_reader;
+static uint32_t capture_start_ms = 0;
+static uint16_t capture_frames[CAPTURE_COPY_FRAMES * 3];
+
+// First sector of a capture file; raw little-endian 12-bit samples follow,
+// interleaved x, y[, temp] per frame
+typedef struct {
+    char magic[4];          // "BDCP"
+    uint16_t version;
+    uint16_t channels;
+    uint32_t frame_rate_hz;
+    uint32_t sample_bits;   // ADC resolution (12)
+    uint64_t start_us;      // time_us_64() of the first frame
+    uint8_t reserved[STREAM_SECTOR_SIZE - 24];
+} capture_header_t;
+#endif
 
 // === Initialize I2C for OLED ===
 void init_i2c(void) {
@@ -100,6 +175,8 @@ void init_gpio(void) {
     gpio_init(BUZZER);
     gpio_set_dir(BUZZER, GPIO_OUT);
     gpio_put(BUZZER, 0);
+    
+    actuators_init();
 
     // Input pins with pull-up
     gpio_init(BUTTON_A);
@@ -109,34 +186,41 @@ void init_gpio(void) {
     gpio_init(BUTTON_B);
     gpio_set_dir(BUTTON_B, GPIO_IN);
     gpio_pull_up(BUTTON_B);
+    
+    // Edge IRQs with microsecond timestamps; debounced from the edge stream
+    static const uint buttons[] = { BUTTON_A, BUTTON_B };
+    button_capture_init(buttons, count_of(buttons), DEBOUNCE_MS * 1000);
 }
 
 // === Initialize ADC for Joystick ===
 void init_adc(void) {
     adc_init();
+#if JOYSTICK_DMA_MODE
+    if (!joystick_dma_init(JOY_X, JOY_Y, JOY_FRAME_RATE_HZ, JOY_SAMPLE_TEMP)) {
+        printf("ERROR: Invalid joystick frame rate %d Hz\n", JOY_FRAME_RATE_HZ);
+    }
+#else
     adc_gpio_init(JOY_X);
     adc_gpio_init(JOY_Y);
+#endif
 }
 
 // === Initialize SD card via SPI ===
+// The SPI pins, chip select and clock come from hw_config.c; the driver sets
+// them up and negotiates the clock with the card during the mount.
 bool init_sd_card(void) {
-    spi_init(spi0, SPI_BAUDRATE);
-    gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
-
     FRESULT fr = f_mount(&fs, "", 1);
     if (fr != FR_OK) {
         printf("ERROR: Failed to mount SD card (error %d)\n", fr);
         return false;
     }
     
-    printf("SD card mounted successfully\n");
+    sd_card_t *sd = sd_get_by_num(0);
+    printf("SD card mounted successfully (SPI %lu kHz, card max %lu kHz, AU %lu KB)\n",
+           sd->clock_hz / 1000, sd->max_clock_hz / 1000, sd->au_sectors / 2);
     
-    fr = f_open(&file, LOG_FILENAME, FA_WRITE | FA_OPEN_APPEND);
+    // Releases a reservation left by an unclean shutdown, then reserves anew
+    fr = log_file_open(&file, LOG_FILENAME, LOG_PREALLOC_BYTES);
     if (fr != FR_OK) {
         printf("ERROR: Failed to open log file (error %d)\n", fr);
         return false;
@@ -145,36 +229,83 @@ bool init_sd_card(void) {
     // Write header only if file is empty
     FSIZE_t size = f_size(&file);
     if (size == 0) {
-        f_puts("Event,Timestamp_ms\n", &file);
-        f_sync(&file);
+#if LOG_FORMAT_BINARY
+        static uint8_t header[LOG_FORMAT_HEADER_SIZE];
+        UINT len = log_format_header(header, sizeof(header));
+        UINT written = 0;
+        fr = len ? f_write(&file, header, len, &written) : FR_INVALID_PARAMETER;
+        if (fr == FR_OK && written != len) {
+            fr = FR_DENIED;  // Card full
+        }
+#else
+        fr = (f_puts("Event,Timestamp_ms,X,Y\n", &file) < 0) ? FR_DISK_ERR : FR_OK;
+#endif
+        if (fr == FR_OK) {
+            fr = f_sync(&file);
+        }
+        if (fr != FR_OK) {
+            // Records after a missing header could not be decoded
+            printf("ERROR: Failed to write log header (error %d)\n", fr);
+            f_close(&file);
+            return false;
+        }
         printf("Log file created with header\n");
     } else {
         printf("Appending to existing log file\n");
     }
     
+    const log_writer_config_t log_config = {
+        .flush_bytes = LOG_FLUSH_BYTES,
+        .flush_age_ms = LOG_FLUSH_AGE_MS,
+        .sync_interval_ms = LOG_SYNC_INTERVAL_MS,
+    };
+    if (!log_writer_init(&file, &log_config)) {
+        return false;
+    }
+    
+#if LOG_FORMAT_BINARY
+    // Marks the boot, so deltas never cross sessions appended to one file
+    uint8_t record[LOG_RECORD_SIZE];
+    return log_writer_append(record, log_format_session(record, time_us_64()));
+#else
     return true;
+#endif
 }
 
 // === Log event to SD with timestamp ===
-void log_event(const char* event) {
+void log_event(const event_t* event) {
+    const char* name = event_name(event->id);
     if (!sd_card_ready) {
-        printf("WARNING: SD card not ready, event not logged: %s\n", event);
+        printf("WARNING: SD card not ready, event not logged: %s\n", name);
         return;
     }
     
-    char line[128];
-    uint32_t timestamp = to_ms_since_boot(get_absolute_time());
-    snprintf(line, sizeof(line), "%s,%lu\n", event, timestamp);
-    
-    UINT bytes_written;
-    FRESULT fr = f_write(&file, line, strlen(line), &bytes_written);
+#if LOG_FORMAT_BINARY
+    // Fixed-size record, no text formatting on the event path
+    uint8_t record[LOG_RECORD_MAX];
+    size_t len = log_format_record(record, event);
+#else
+    // Time of detection (not of logging), in ms with microsecond resolution
+    char record[128];
+    uint32_t timestamp_ms = (uint32_t)(event->timestamp_us / 1000);
+    uint32_t fraction_us = (uint32_t)(event->timestamp_us % 1000);
+    if (event->id == EVENT_JOYSTICK_POS) {
+        snprintf(record, sizeof(record), "%s,%lu.%03lu,%lu,%lu\n", name, timestamp_ms, fraction_us,
+                 event->payload & 0xFFF, (event->payload >> 12) & 0xFFF);
+    } else {
+        snprintf(record, sizeof(record), "%s,%lu.%03lu,,\n", name, timestamp_ms, fraction_us);
+    }
+    size_t len = strlen(record);
+#endif
     
-    if (fr != FR_OK || bytes_written != strlen(line)) {
-        printf("ERROR: Failed to write to log file (error %d)\n", fr);
+    // Buffered: the log writer batches records into whole-sector writes
+    if (!log_writer_append(record, len)) {
+        log_writer_stats_t stats;
+        log_writer_get_stats(&stats);
+        printf("ERROR: Failed to write to log file (error %d)\n", stats.last_error);
         sd_card_ready = false;
-    } else {
-        f_sync(&file);
-        printf("Event logged: %s", line);
+    } else if (!event_is_sample(event->id)) {
+        printf("Event logged: %s @ %lu us\n", name, (uint32_t)event->timestamp_us);
     }
 }
 
@@ -190,55 +321,587 @@ void display_event(const char* message) {
     char status[32];
     snprintf(status, sizeof(status), "SD: %s", sd_card_ready ? "OK" : "ERROR");
     ssd1306_WriteString(status, Font_6x8, White);
+    // Sent by DMA in the background; if a frame is still in flight, this one
+    // is retried from sink_task()
+    display_pending = !ssd1306_Present(NULL, NULL);
+}
+
+// === Hand a timestamped event to the sink ===
+void post_event(event_id_t id, uint32_t payload, uint64_t timestamp_us) {
+    event_t event = {
+        .timestamp_us = timestamp_us,
+        .payload = payload,
+        .id = id,
+    };
+    if (!event_queue_push(&event_queue, &event)) {
+        printf("WARNING: Event queue full, dropped %s\n", event_name(id));
+    }
+#if DUAL_CORE_MODE
+    __sev();  // Wake core1 if it is waiting for work
+#endif
+}
+
+// === Report edge capture counters ===
+void print_button_stats(void) {
+    button_capture_stats_t stats;
+    button_capture_get_stats(&stats);
+    printf("Buttons: %lu edges, %lu bounces, ring high-water %lu, overflows %lu\n",
+           stats.edges, stats.bounces, stats.high_water, stats.overflows);
+}
+
+// === Report joystick DMA sampling counters ===
+void print_joystick_stats(void) {
+#if JOYSTICK_DMA_MODE
+    joystick_dma_stats_t stats;
+    joystick_dma_get_stats(&stats);
+    printf("Joystick: %lu frames at %lu Hz, overruns %lu\n",
+           stats.frames, stats.frame_rate_hz, stats.overruns);
+#endif
+}
+
+// === Report SPI transfers per path since the previous report ===
+void print_spi_stats(void) {
+    spi_t *spi = sd_get_by_num(0)->spi;
+    spi_stats_t stats;
+    spi_get_stats(spi, &stats, true);
+    printf("SPI (polled <= %u B): polled %lu calls/%lu B in %lu us, DMA %lu calls/%lu B in %lu us\n",
+           spi->polled_max, stats.polled_calls, stats.polled_bytes, (uint32_t)stats.polled_us,
+           stats.dma_calls, stats.dma_bytes, (uint32_t)stats.dma_us);
+    sd_card_t *sd = sd_get_by_num(0);
+    printf("SPI clock %lu kHz, lowered %lu times after transfer errors\n",
+           sd->clock_hz / 1000, sd->clock_fallbacks);
+}
+
+// === Report card busy waits since the previous report (log2 histogram) ===
+void print_busy_stats(void) {
+    if (!sd_card_ready) {
+        return;
+    }
+    sd_busy_stats_t stats;
+    sd_get_busy_stats(sd_get_by_num(0), &stats, true);
+    printf("SD busy: %lu waits, %lu us total, max %lu us, timeouts %lu\n",
+           stats.waits, (uint32_t)stats.total_us, stats.max_us, stats.timeouts);
+    printf("  ready at first poll %lu", stats.ready_first);
+    for (uint i = 0; i < SD_BUSY_HIST_BUCKETS; i++) {
+        if (stats.hist[i]) {
+            printf(", <%luus %lu", 1ul << i, stats.hist[i]);
+        }
+    }
+    printf("\n");
+}
+
+// === Report sector cache activity since mount ===
+void print_cache_stats(void) {
+    sector_cache_t *cache = disk_get_cache(0);
+    if (!cache) {
+        return;
+    }
+    sector_cache_stats_t stats;
+    sector_cache_get_stats(cache, &stats);
+    uint32_t lookups = stats.hits + stats.misses;
+    printf("Cache: %lu hits, %lu misses (%lu%% hit), %lu evictions, %lu sectors in %lu write-backs, %lu bypassed\n",
+           stats.hits, stats.misses, lookups ? stats.hits * 100 / lookups : 0,
+           stats.evictions, stats.written_back, stats.writebacks, stats.bypassed);
+}
+
+// === Report OLED refresh traffic (only changed spans are sent) ===
+void print_display_stats(void) {
+    SSD1306_Stats_t stats;
+    ssd1306_GetStats(&stats);
+    printf("OLED: %lu frames (%lu unchanged), %lu windows, last %lu B, avg %lu B/frame, %lu errors\n",
+           stats.frames, stats.skipped, stats.windows, stats.last_bytes,
+           stats.frames ? stats.total_bytes / stats.frames : 0, stats.errors);
+}
+
+#if DUAL_CORE_MODE
+// Core1 stack (PICO_CORE1_STACK_SIZE, in SCRATCH_X), from the SDK linker script
+extern uint32_t __StackOneBottom[], __StackOneTop[];
+#define CORE1_STACK_PAINT   0xC1C1C1C1u
+
+// === Fill core1's stack with a pattern before launch, for the high-water mark ===
+void paint_core1_stack(void) {
+    for (uint32_t *p = __StackOneBottom; p < __StackOneTop; p++) {
+        *p = CORE1_STACK_PAINT;
+    }
+}
+
+// === Report the deepest core1 stack use since boot ===
+void print_core1_stack(void) {
+    uint32_t *p = __StackOneBottom;
+    while (p < __StackOneTop && *p == CORE1_STACK_PAINT) {
+        p++;
+    }
+    printf("Core1 stack: %u of %u bytes used\n",
+           (uint)((__StackOneTop - p) * sizeof(uint32_t)),
+           (uint)((__StackOneTop - __StackOneBottom) * sizeof(uint32_t)));
+}
+#endif
+
+// === Step the polled/DMA crossover: 0 (all DMA), 1, 2, 4 ... 512 ===
+void step_spi_threshold(void) {
+    spi_t *spi = sd_get_by_num(0)->spi;
+    uint next = spi->polled_max ? spi->polled_max * 2 : 1;
+    if (next > 512) {
+        next = 0;
+    }
+    spi_set_polled_max(spi, next);
+    print_spi_stats();  // Closes the window measured with the old threshold
+    printf("SPI polled threshold now %u bytes\n", next);
+}
+
+// === Report queue depth, high-water mark and overflows ===
+void print_queue_stats(void) {
+    printf("Queue: depth %lu, high-water %lu/%d, overflows %lu\n",
+           event_queue_count(&event_queue), event_queue.high_water,
+           EVENT_QUEUE_CAPACITY, event_queue.overflows);
+}
+
+#if JOYSTICK_DMA_MODE
+// === Start a raw joystick capture into the next free capNNNN.bin ===
+void start_capture(void) {
+    char path[16];
+    FILINFO info;
+    FRESULT fr;
+    uint index = 0;
+    do {
+        snprintf(path, sizeof(path), "cap%04u.bin", index++);
+        fr = f_stat(path, &info);
+    } while (fr == FR_OK && index < 10000);
+    
+    // Never reuse a name: that would overwrite an earlier capture
+    if (fr == FR_OK) {
+        printf("Capture refused: cap0000.bin to cap9999.bin all exist\n");
+        return;
+    }
+    if (fr != FR_NO_FILE) {
+        printf("Capture refused: cannot check %s (error %d)\n", path, fr);
+        return;
+    }
+    
+    uint32_t frame_bytes = joystick_dma_channels() * sizeof(uint16_t);
+    uint32_t data_bytes = (uint32_t)((uint64_t)CAPTURE_FRAME_RATE_HZ * CAPTURE_DURATION_MS / 1000) * frame_bytes;
+    uint32_t max_bytes = STREAM_SECTOR_SIZE + data_bytes;
+    max_bytes = (max_bytes + STREAM_CHUNK_BYTES - 1) / STREAM_CHUNK_BYTES * STREAM_CHUNK_BYTES;
+    
+    if (!stream_capture_open(path, max_bytes)) {
+        return;
+    }
+    joystick_dma_set_rate(CAPTURE_FRAME_RATE_HZ);
+    joystick_dma_reader_init(&capture_reader);
+    
+    static capture_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "BDCP", 4);
+    header.version = 1;
+    header.channels = joystick_dma_channels();
+    header.frame_rate_hz = CAPTURE_FRAME_RATE_HZ;
+    header.sample_bits = 12;
+    header.start_us = time_us_64();
+    stream_capture_write(&header, sizeof(header));
+    
+    capture_start_ms = to_ms_since_boot(get_absolute_time());
+    printf("Capture started: %s, %d Hz for %d ms\n", path, CAPTURE_FRAME_RATE_HZ, CAPTURE_DURATION_MS);
+}
+
+// === Finish the capture and report the sustained write rate ===
+void stop_capture(void) {
+    bool ok = stream_capture_close();
+    joystick_dma_set_rate(JOY_FRAME_RATE_HZ);
+    
+    stream_capture_stats_t stats;
+    stream_capture_get_stats(&stats);
+    uint32_t write_ms = (uint32_t)(stats.write_time_us / 1000);
+    printf("Capture %s: %lu bytes in %lu ms, %lu writes in %lu sessions (max %lu us), card %lu KB/s, ring overruns %lu\n",
+           ok ? "done" : "FAILED", stats.bytes, stats.elapsed_ms, stats.writes, stats.sessions, stats.max_write_us,
+           write_ms ? stats.bytes / write_ms : 0, capture_reader.overruns);
+}
+
+// === Move new frames from the ADC ring to the capture file ===
+void capture_task(void) {
+    if (!stream_capture_active()) {
+        return;
+    }
+    
+    uint frame_bytes = joystick_dma_channels() * sizeof(uint16_t);
+    uint count;
+    bool ok = true;
+    while (ok && (count = joystick_dma_copy(&capture_reader, capture_frames, CAPTURE_COPY_FRAMES)) > 0) {
+        ok = stream_capture_write(capture_frames, count * frame_bytes);
+    }
+    
+    uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - capture_start_ms;
+    if (!ok || elapsed >= CAPTURE_DURATION_MS) {
+        stop_capture();
+    }
+}
+#endif
+
+// === Show SD status once initialization is done ===
+void show_ready_screen(bool ready) {
+    ssd1306_Fill(Black);
+    ssd1306_SetCursor(0, 0);
+    if (ready) {
+        ssd1306_WriteString("System Ready", Font_6x8, White);
+        ssd1306_SetCursor(0, 16);
+        ssd1306_WriteString("Waiting input", Font_6x8, White);
+    } else {
+        ssd1306_WriteString("SD CARD ERROR", Font_6x8, White);
+        ssd1306_SetCursor(0, 16);
+        ssd1306_WriteString("Check card!", Font_6x8, White);
+    }
+    ssd1306_UpdateScreen();
+}
+
+// === Reformat the card for its capacity and AU, then benchmark it ===
+bool format_card(void) {
+#if JOYSTICK_DMA_MODE
+    if (stream_capture_active()) {
+        stop_capture();
+    }
+#endif
+    if (sd_card_ready) {
+        sd_card_ready = false;
+        log_writer_flush(true);
+        log_file_close(&file);
+    }
+    
+    ssd1306_Fill(Black);
+    ssd1306_SetCursor(0, 0);
+    ssd1306_WriteString("Formatting SD...", Font_6x8, White);
     ssd1306_UpdateScreen();
+    
+    sd_format_plan_t plan;
+    FRESULT fr = sd_format(0, LOG_FLUSH_BYTES, &plan);
+    if (fr != FR_OK) {
+        printf("ERROR: Format failed (error %d)\n", fr);
+    } else if ((fr = f_mount(&fs, "", 1)) == FR_OK) {
+        static const char *const fs_names[] = { "?", "FAT12", "FAT16", "FAT32", "exFAT" };
+        printf("Formatted: %s, %lu KB clusters, data area at sector %lu (AU %lu KB)\n",
+               fs_names[fs.fs_type <= FS_EXFAT ? fs.fs_type : 0], (uint32_t)fs.csize / 2,
+               (uint32_t)fs.database, plan.align_sectors / 2);
+        
+        sd_format_bench_t bench;
+        fr = sd_format_benchmark(FORMAT_BENCH_FILE, FORMAT_BENCH_BYTES, SD_FORMAT_BUF_BYTES, &bench);
+        uint32_t rate = bench.elapsed_us ? (uint32_t)((uint64_t)bench.bytes * 100 / bench.elapsed_us) : 0;
+        printf("Sequential write %s: %lu KB in %lu ms, %lu.%02lu MB/s (slowest write %lu us)\n",
+               fr == FR_OK ? "done" : "FAILED", bench.bytes / 1024, bench.elapsed_us / 1000,
+               rate / 100, rate % 100, bench.max_write_us);
+    }
+    
+    bool ready = init_sd_card();
+    show_ready_screen(ready);
+    sd_card_ready = ready;
+    return ready;
+}
+
+// === FatFs RAM use, and write throughput per f_write size ===
+// Compare builds with -DFF_FS_TINY=0 and 1: the small writes show what the
+// per-file sector buffer costs or saves, the large ones are unaffected.
+void run_write_benchmark(void) {
+    static const uint32_t write_sizes[] = { 32, 512, 4096, SD_FORMAT_BUF_BYTES };
+    
+    if (!sd_card_ready) {
+        printf("Benchmark unavailable: SD card not ready\n");
+        return;
+    }
+    printf("FatFs RAM (FF_FS_TINY=%d): FATFS %u B, FIL %u B; log ring %d B, sector cache %u B\n",
+           FF_FS_TINY, sizeof(FATFS), sizeof(FIL), LOG_WRITER_RING_SIZE,
+           disk_get_cache(0) ? sizeof(sector_cache_t) : 0);
+    
+    log_writer_flush(false);  // Keep the log's own writes out of the timing
+    for (uint i = 0; i < count_of(write_sizes); i++) {
+        sd_format_bench_t bench;
+        FRESULT fr = sd_format_benchmark(FORMAT_BENCH_FILE, WRITE_BENCH_BYTES, write_sizes[i], &bench);
+        uint32_t rate = bench.elapsed_us ? (uint32_t)((uint64_t)bench.bytes * 100 / bench.elapsed_us) : 0;
+        printf("  %5lu B writes: %lu KB in %lu ms, %lu.%02lu MB/s (slowest %lu us)%s\n",
+               bench.write_bytes, bench.bytes / 1024, bench.elapsed_us / 1000,
+               rate / 100, rate % 100, bench.max_write_us, fr == FR_OK ? "" : " FAILED");
+    }
+}
+
+// === Glyphs drawn per second with the display font ===
+// Row 8 is page-aligned (whole-byte stores); row 3 needs shifted, masked ones.
+// Characters left out of the build (OLED_FONT_CHARS) are not counted.
+static uint32_t glyph_rate(uint8_t y) {
+    uint32_t span = SSD1306_WIDTH - Font_6x8.width;
+    uint32_t drawn = 0;
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < GLYPH_BENCH_GLYPHS; i++) {
+        ssd1306_SetCursor((i * Font_6x8.width) % span, y);
+        if (ssd1306_WriteChar('!' + i % 94, Font_6x8, White)) {
+            drawn++;
+        }
+    }
+    uint64_t elapsed = time_us_64() - start;
+    return elapsed ? (uint32_t)(drawn * 1000000ull / elapsed) : 0;
+}
+
+void run_glyph_benchmark(void) {
+    printf("Font_6x8 glyphs/s (%d per run): row 8 %lu, row 3 %lu\n",
+           GLYPH_BENCH_GLYPHS, glyph_rate(8), glyph_rate(3));
+    show_ready_screen(sd_card_ready);  // The runs drew over the frame
+}
+
+// === Serial console commands (sink side, which owns the card) ===
+void handle_command(int c) {
+    static uint32_t format_armed_ms = 0;
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    
+    switch (c) {
+        case 'F':
+            // Destructive: needs a second 'F' to confirm
+            if (format_armed_ms != 0 && now_ms - format_armed_ms < FORMAT_CONFIRM_MS) {
+                format_armed_ms = 0;
+                format_card();
+            } else {
+                format_armed_ms = now_ms ? now_ms : 1;
+                printf("Send F again within %d s to ERASE and format the SD card\n", FORMAT_CONFIRM_MS / 1000);
+            }
+            break;
+#if JOYSTICK_DMA_MODE
+        case 'c':
+            if (!sd_card_ready) {
+                printf("Capture unavailable: SD card not ready\n");
+            } else if (stream_capture_active()) {
+                stop_capture();
+            } else {
+                start_capture();
+            }
+            break;
+#endif
+        case 'b':
+            run_write_benchmark();
+            break;
+        case 'g':
+            run_glyph_benchmark();
+            break;
+        case 's':
+            print_spi_stats();
+            print_busy_stats();
+            print_cache_stats();
+            print_display_stats();
+#if DUAL_CORE_MODE
+            print_core1_stack();
+#endif
+            break;
+        case 't':
+            step_spi_threshold();
+            break;
+        default:
+            break;
+    }
 }
 
-// === Check button state with debounce ===
-bool is_button_pressed(uint8_t pin, bool* last_state, uint32_t* last_time) {
-    bool current_state = !gpio_get(pin);  // Active low
+// === Sink task: drain queued events to the SD card and OLED ===
+void sink_task(void) {
+    event_t event;
+    uint8_t last_id = EVENT_NONE;
+    
+    int c = getchar_timeout_us(0);
+    if (c != PICO_ERROR_TIMEOUT) {
+        handle_command(c);
+    }
+#if JOYSTICK_DMA_MODE
+    capture_task();
+#endif
+    
+    while (event_queue_pop(&event_queue, &event)) {
+        log_event(&event);
+        if (!event_is_sample(event.id)) {
+            last_id = event.id;
+        }
+    }
+    
+    // The OLED only shows the latest event, so refresh it once per batch
+    if (last_id != EVENT_NONE) {
+        display_event(event_display_text(last_id));
+    } else if (display_pending) {
+        display_pending = !ssd1306_Present(NULL, NULL);
+    }
+    
+    // Age-based flush and metadata sync happen here, off the event path
+    if (sd_card_ready && !log_writer_poll()) {
+        printf("ERROR: Log writer flush failed\n");
+        sd_card_ready = false;
+    }
+    
     uint32_t current_time = to_ms_since_boot(get_absolute_time());
+    if ((current_time - last_stats_time) >= STATS_INTERVAL_MS) {
+        if (sd_card_ready) {
+            log_writer_print_stats();
+        }
+        print_queue_stats();
+        print_button_stats();
+        print_joystick_stats();
+        last_stats_time = current_time;
+    }
+}
+
+// === Power-up format gesture: A+B held for FORMAT_HOLD_MS ===
+// The OLED counts down; releasing either button (for longer than a bounce)
+// cancels. Returns true only if both stayed held for the whole period.
+static bool format_hold_confirmed(void) {
+    if (gpio_get(BUTTON_A) || gpio_get(BUTTON_B)) {
+        return false;
+    }
+    printf("Buttons A+B held: keep holding %d s to ERASE and format the SD card\n",
+           FORMAT_HOLD_MS / 1000);
     
-    // Detect rising edge with debounce
-    if (current_state && !(*last_state) && (current_time - *last_time) > DEBOUNCE_MS) {
-        *last_state = current_state;
-        *last_time = current_time;
-        return true;
+    uint32_t start_ms = to_ms_since_boot(get_absolute_time());
+    uint32_t released_ms = 0;
+    uint32_t shown = 0;
+    while (true) {
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        uint32_t elapsed = now_ms - start_ms;
+        if (elapsed >= FORMAT_HOLD_MS) {
+            return true;
+        }
+        
+        if (gpio_get(BUTTON_A) || gpio_get(BUTTON_B)) {
+            if (released_ms == 0) {
+                released_ms = now_ms ? now_ms : 1;
+            } else if (now_ms - released_ms >= DEBOUNCE_MS) {
+                printf("Format cancelled\n");
+                return false;
+            }
+        } else {
+            released_ms = 0;
+        }
+        
+        uint32_t remaining = (FORMAT_HOLD_MS - elapsed + 999) / 1000;
+        if (remaining != shown) {
+            char line[24];
+            snprintf(line, sizeof(line), "Formatting in %lu s", remaining);
+            ssd1306_Fill(Black);
+            ssd1306_SetCursor(0, 0);
+            ssd1306_WriteString("Hold A+B to format", Font_6x8, White);
+            ssd1306_SetCursor(0, 16);
+            ssd1306_WriteString(line, Font_6x8, White);
+            ssd1306_SetCursor(0, 32);
+            ssd1306_WriteString("Release to cancel", Font_6x8, White);
+            ssd1306_UpdateScreen();
+            shown = remaining;
+        }
+        sleep_ms(LOOP_DELAY_MS);
+    }
+}
+
+// === Bring up the storage/display side: OLED, SD card, log file ===
+bool init_sink(void) {
+    printf("Initializing OLED...\n");
+    init_oled();
+    sleep_ms(1000);
+    
+    // Both buttons held through the countdown: reformat instead of mounting
+    if (format_hold_confirmed()) {
+        printf("Buttons A+B held: formatting SD card...\n");
+        return format_card();
     }
     
-    *last_state = current_state;
-    return false;
+    printf("Initializing SD card...\n");
+    bool ready = init_sd_card();
+    show_ready_screen(ready);
+    return ready;
+}
+
+#if DUAL_CORE_MODE
+// === Core1: owns FatFs, the SD driver and the OLED ===
+// Initialization also runs here, so the SPI DMA completion IRQ is enabled on
+// core1 and a multi-millisecond card busy period never touches core0.
+void core1_main(void) {
+    bool ready = init_sink();
+    multicore_fifo_push_blocking(ready ? 1 : 0);  // Report to core0
+    
+    while (true) {
+        sink_task();
+        if (event_queue_count(&event_queue) == 0) {
+            // Woken by __sev() from post_event() or by the flush deadline
+            best_effort_wfe_or_timeout(make_timeout_time_ms(SINK_IDLE_WAIT_MS));
+        }
+    }
 }
+#endif
 
 // === Handle LED with automatic turn-off ===
-void blink_led(uint8_t led_pin, const char* event_msg) {
-    gpio_put(led_pin, 1);
-    log_event(event_msg);
-    display_event(event_msg);
-    sleep_ms(LED_DURATION_MS);
-    gpio_put(led_pin, 0);
+// The turn-off is scheduled on a hardware alarm, so sampling continues while
+// the LED is lit and a burst of presses is logged at its real rate.
+void blink_led(uint8_t led_pin, event_id_t event, uint64_t timestamp_us) {
+    post_event(event, 0, timestamp_us);
+    actuator_pulse(led_pin, LED_DURATION_MS);
 }
 
 // === Handle buzzer activation ===
-void activate_buzzer(void) {
-    gpio_put(BUZZER, 1);
-    log_event("BUZZER_ACTIVATED");
-    display_event("BUZZER ACTIVATED");
-    sleep_ms(LED_DURATION_MS);
-    gpio_put(BUZZER, 0);
+void activate_buzzer(uint64_t timestamp_us) {
+    post_event(EVENT_BUZZER_ACTIVATED, 0, timestamp_us);
+    actuator_pulse(BUZZER, LED_DURATION_MS);
 }
 
 // === Check joystick movement ===
 bool check_joystick_movement(void) {
+#if JOYSTICK_DMA_MODE
+    joystick_frame_t frame;
+    if (!joystick_dma_latest(&frame)) {
+        return false;
+    }
+    uint16_t x = frame.x;
+    uint16_t y = frame.y;
+#else
     adc_select_input(0);
     uint16_t x = adc_read();
     
     adc_select_input(1);
     uint16_t y = adc_read();
+#endif
     
     return (x < JOY_MIN_THRESHOLD || x > JOY_MAX_THRESHOLD || 
             y < JOY_MIN_THRESHOLD || y > JOY_MAX_THRESHOLD);
 }
 
+// === Sample inputs and queue their events (no card or display access) ===
+void sample_inputs(void) {
+    // Debounced presses from the IRQ edge stream, with edge timestamps
+    button_press_t press;
+    while (button_capture_next(&press)) {
+        bool is_a = (press.gpio == BUTTON_A);
+        // Check if both buttons pressed simultaneously
+        if (button_capture_is_pressed(is_a ? BUTTON_B : BUTTON_A)) {
+            activate_buzzer(press.timestamp_us);
+        } else if (is_a) {
+            blink_led(RED_LED, EVENT_BUTTON_A_PRESSED, press.timestamp_us);
+        } else {
+            blink_led(GREEN_LED, EVENT_BUTTON_B_PRESSED, press.timestamp_us);
+        }
+    }
+
+    // Check joystick movement with throttling
+    uint32_t current_time = to_ms_since_boot(get_absolute_time());
+    if ((current_time - last_joystick_time) > LED_DURATION_MS) {
+        if (check_joystick_movement()) {
+            blink_led(BLUE_LED, EVENT_JOYSTICK_MOVED, time_us_64());
+            last_joystick_time = current_time;
+        }
+    }
+
+#if JOYSTICK_DMA_MODE
+    // Trajectory: mean of the DMA frames collected since the last sample
+    if ((current_time - last_joystick_log_time) >= JOY_LOG_INTERVAL_MS) {
+        joystick_frame_t mean;
+        if (joystick_dma_consume(&mean) > 0) {
+            post_event(EVENT_JOYSTICK_POS, mean.x | ((uint32_t)mean.y << 12), time_us_64());
+        }
+        last_joystick_log_time = current_time;
+    }
+#endif
+}
+
+#if !DUAL_CORE_MODE
+// === Keep sampling while the card is busy programming flash ===
+static void sample_while_busy(void *ctx) {
+    (void)ctx;
+    sample_inputs();
+}
+#endif
+
 // === Main function ===
 int main(void) {
     // Initialize standard I/O
@@ -257,75 +920,48 @@ int main(void) {
     printf("Initializing I2C...\n");
     init_i2c();
     
-    printf("Initializing OLED...\n");
-    init_oled();
-    sleep_ms(1000);
-    
     printf("Initializing GPIO...\n");
     init_gpio();
     
     printf("Initializing ADC...\n");
     init_adc();
     
-    printf("Initializing SD card...\n");
-    sd_card_ready = init_sd_card();
+    event_queue_init(&event_queue);
+    
+#if DUAL_CORE_MODE
+    printf("Starting core1 (SD card + OLED)...\n");
+    paint_core1_stack();
+    multicore_launch_core1(core1_main);
+    sd_card_ready = multicore_fifo_pop_blocking() != 0;
+#else
+    sd_card_ready = init_sink();
+    // Single core: card busy time is spent sampling instead of spinning
+    sd_set_busy_yield(sd_get_by_num(0), sample_while_busy, NULL);
+#endif
     
     if (sd_card_ready) {
         printf("System ready!\n");
-        ssd1306_Fill(Black);
-        ssd1306_SetCursor(0, 0);
-        ssd1306_WriteString("System Ready", Font_6x8, White);
-        ssd1306_SetCursor(0, 16);
-        ssd1306_WriteString("Waiting input", Font_6x8, White);
-        ssd1306_UpdateScreen();
     } else {
         printf("WARNING: Running without SD card logging\n");
-        ssd1306_Fill(Black);
-        ssd1306_SetCursor(0, 0);
-        ssd1306_WriteString("SD CARD ERROR", Font_6x8, White);
-        ssd1306_SetCursor(0, 16);
-        ssd1306_WriteString("Check card!", Font_6x8, White);
-        ssd1306_UpdateScreen();
     }
 
     // === Main loop ===
     printf("\nEntering main loop...\n");
     
     while (true) {
-        // Check Button A with debounce
-        if (is_button_pressed(BUTTON_A, &last_button_a_state, &last_button_time_a)) {
-            // Check if both buttons pressed simultaneously
-            if (!gpio_get(BUTTON_B)) {
-                activate_buzzer();
-            } else {
-                blink_led(RED_LED, "BUTTON_A_PRESSED");
-            }
-        }
-        
-        // Check Button B with debounce
-        if (is_button_pressed(BUTTON_B, &last_button_b_state, &last_button_time_b)) {
-            // Check if both buttons pressed simultaneously
-            if (!gpio_get(BUTTON_A)) {
-                activate_buzzer();
-            } else {
-                blink_led(GREEN_LED, "BUTTON_B_PRESSED");
-            }
-        }
+        sample_inputs();
 
-        // Check joystick movement with throttling
-        uint32_t current_time = to_ms_since_boot(get_absolute_time());
-        if ((current_time - last_joystick_time) > LED_DURATION_MS) {
-            if (check_joystick_movement()) {
-                blink_led(BLUE_LED, "JOYSTICK_MOVED");
-                last_joystick_time = current_time;
-            }
-        }
+#if !DUAL_CORE_MODE
+        // Storage and display work runs after sampling, from the queue
+        sink_task();
+#endif
 
         sleep_ms(LOOP_DELAY_MS);
     }
 
     // Cleanup (never reached in this implementation)
-    f_close(&file);
+    log_writer_flush(true);
+    log_file_close(&file);
     f_unmount("");
     
     return 0;
@@ -0,0 +1,146 @@
+/**
+ * @file sd_format.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Card formatting matched to the card's capacity and erase block
+ *
+ * The AU comes from the SD driver (SD Status AU_SIZE, read at init). If the
+ * chosen cluster size breaks the cluster count limits of the file system type
+ * on a card of unusual size, f_mkfs is run again with FatFs's own default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "diskio.h"
+#include "hw_config.h"
+#include "sd_format.h"
+
+// Capacity classes, in 512-byte sectors
+#define SECTORS_2GB     (4ull * 1024 * 1024)
+#define SECTORS_32GB    (64ull * 1024 * 1024)
+#define SECTORS_512GB   (1024ull * 1024 * 1024)
+
+// === File system type and cluster size for a card ===
+void sd_format_plan(uint64_t sectors, uint32_t au_sectors, uint32_t write_bytes,
+                    sd_format_plan_t *plan) {
+    uint32_t max_cluster;
+    if (sectors <= SECTORS_2GB) {
+        plan->fmt = FM_FAT;             // SDSC: FAT12/16, FatFs picks the cluster
+        plan->cluster_bytes = 0;
+        max_cluster = 32768;
+    } else if (sectors <= SECTORS_32GB) {
+        plan->fmt = FM_FAT32;           // SDHC
+        plan->cluster_bytes = 32768;
+        max_cluster = 65536;
+    } else {
+        plan->fmt = FM_EXFAT;           // SDXC
+        plan->cluster_bytes = (sectors > SECTORS_512GB) ? 262144 : 131072;
+        max_cluster = 16 * 1024 * 1024;
+    }
+
+    // At least one whole log write per cluster: fewer allocations, and so
+    // fewer FAT updates, per MB logged
+    if (plan->cluster_bytes && plan->cluster_bytes < write_bytes) {
+        uint32_t bytes = plan->cluster_bytes;
+        while (bytes < write_bytes && bytes < max_cluster) {
+            bytes *= 2;
+        }
+        plan->cluster_bytes = bytes;
+    }
+
+    // A cluster never spans two erase blocks
+    uint32_t au_bytes = au_sectors * 512;
+    if (au_sectors > 1 && plan->cluster_bytes > au_bytes) {
+        plan->cluster_bytes = au_bytes;
+    }
+    plan->align_sectors = au_sectors;
+}
+
+// === Create a new volume on the whole card (existing data is lost) ===
+FRESULT sd_format(BYTE pdrv, uint32_t write_bytes, sd_format_plan_t *plan) {
+    sd_card_t *sd = sd_get_by_num(pdrv);
+    if (sd == NULL) {
+        return FR_INVALID_DRIVE;
+    }
+    if (disk_initialize(pdrv) & STA_NOINIT) {
+        return FR_NOT_READY;
+    }
+    sd_format_plan(sd->sectors, sd->au_sectors, write_bytes, plan);
+
+    uint8_t *work = malloc(SD_FORMAT_BUF_BYTES);
+    if (work == NULL) {
+        return FR_NOT_ENOUGH_CORE;
+    }
+
+    char path[4];
+    snprintf(path, sizeof(path), "%u:", pdrv);
+    MKFS_PARM opt = {
+        .fmt = plan->fmt,
+        .n_fat = 1,
+        .align = plan->align_sectors,
+        .au_size = plan->cluster_bytes,
+    };
+    FRESULT fr = f_mkfs(path, &opt, work, SD_FORMAT_BUF_BYTES);
+    if (fr == FR_MKFS_ABORTED && opt.au_size != 0) {
+        opt.au_size = plan->cluster_bytes = 0;
+        fr = f_mkfs(path, &opt, work, SD_FORMAT_BUF_BYTES);
+    }
+    free(work);
+    return fr;
+}
+
+// === Write total_bytes sequentially to a new file, then delete it ===
+// Writes of whole sectors at sector-aligned offsets go straight to
+// disk_write; smaller ones are gathered in a FatFs sector buffer first.
+FRESULT sd_format_benchmark(const char *path, uint32_t total_bytes, uint32_t write_bytes,
+                            sd_format_bench_t *bench) {
+    memset(bench, 0, sizeof(*bench));
+    if (write_bytes == 0 || write_bytes > SD_FORMAT_BUF_BYTES) {
+        return FR_INVALID_PARAMETER;
+    }
+    bench->write_bytes = write_bytes;
+    uint8_t *buf = malloc(SD_FORMAT_BUF_BYTES);
+    if (buf == NULL) {
+        return FR_NOT_ENOUGH_CORE;
+    }
+    for (uint32_t i = 0; i < SD_FORMAT_BUF_BYTES; i++) {
+        buf[i] = (uint8_t)i;
+    }
+
+    static FIL fil;     // Off the stack: core1 runs this from the console handler
+    uint32_t start_us = time_us_32();
+    FRESULT fr = f_open(&fil, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (fr != FR_OK) {
+        free(buf);
+        return fr;
+    }
+    while (fr == FR_OK && bench->bytes < total_bytes) {
+        UINT len = write_bytes;
+        if (len > total_bytes - bench->bytes) {
+            len = total_bytes - bench->bytes;
+        }
+        UINT written = 0;
+        uint32_t write_start = time_us_32();
+        fr = f_write(&fil, buf, len, &written);
+        uint32_t elapsed = time_us_32() - write_start;
+        if (elapsed > bench->max_write_us) {
+            bench->max_write_us = elapsed;
+        }
+        if (fr == FR_OK && written < len) {
+            fr = FR_DENIED;     // Card full
+        }
+        bench->bytes += written;
+    }
+    FRESULT fr_close = f_close(&fil);
+    if (fr == FR_OK) {
+        fr = fr_close;
+    }
+    bench->elapsed_us = time_us_32() - start_us;
+
+    f_unlink(path);
+    free(buf);
+    return fr;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file sd_format.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief Card formatting matched to the card's capacity and erase block
+ *
+ * The file system type and cluster size follow the SD Association's layout
+ * for the card's capacity class (FAT12/16 up to 2 GB, FAT32 up to 32 GB,
+ * exFAT above), with clusters no smaller than the log's write size and no
+ * larger than the card's allocation unit (AU). The data area starts on an AU
+ * boundary, so cluster writes never straddle two erase blocks.
+ */
+
+#ifndef SD_FORMAT_H
+#define SD_FORMAT_H
+
+#include <stdint.h>
+#include "ff.h"
+
+// === Build-time Configuration ===
+// Work buffer for f_mkfs and largest benchmark write (heap, freed after)
+#ifndef SD_FORMAT_BUF_BYTES
+#define SD_FORMAT_BUF_BYTES     16384
+#endif
+
+typedef struct {
+    BYTE fmt;               // FM_FAT, FM_FAT32 or FM_EXFAT
+    DWORD cluster_bytes;    // Requested cluster size (0: FatFs default)
+    DWORD align_sectors;    // Data area alignment (the AU; 0: GET_BLOCK_SIZE)
+} sd_format_plan_t;
+
+typedef struct {
+    uint32_t write_bytes;   // Bytes per f_write
+    uint32_t bytes;         // Bytes written, including the final f_sync
+    uint32_t elapsed_us;    // Open to close
+    uint32_t max_write_us;  // Slowest single f_write
+} sd_format_bench_t;
+
+void sd_format_plan(uint64_t sectors, uint32_t au_sectors, uint32_t write_bytes,
+                    sd_format_plan_t *plan);
+FRESULT sd_format(BYTE pdrv, uint32_t write_bytes, sd_format_plan_t *plan);
+FRESULT sd_format_benchmark(const char *path, uint32_t total_bytes, uint32_t write_bytes,
+                            sd_format_bench_t *bench);
+
+#endif // SD_FORMAT_H
@@ -0,0 +1,178 @@
+/**
+ * @file stream_capture.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief High-rate capture written as raw sectors into a contiguous file
+ *
+ * The first sector of the run is database + (sclust - 2) * csize, the same
+ * mapping FatFs uses internally (clst2sect). Nothing is read or written
+ * through the FIL while the capture is open, so its sector buffer never holds
+ * stale data for the region written behind FatFs's back; the disk sector
+ * cache is told to forget the region at open.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ff.h"
+#include "hw_config.h"
+#include "sector_cache.h"
+#include "stream_capture.h"
+
+#if (STREAM_CHUNK_BYTES % STREAM_SECTOR_SIZE) != 0
+#error "STREAM_CHUNK_BYTES must be a multiple of the sector size"
+#endif
+
+// === Module State ===
+static FIL capture_file;
+static sd_card_t *capture_sd = NULL;
+static bool capture_open = false;
+static LBA_t next_lba = 0;          // Next sector to write
+static LBA_t end_lba = 0;           // One past the last reserved sector
+static uint8_t chunk[STREAM_CHUNK_BYTES] __attribute__((aligned(4)));
+static size_t chunk_len = 0;
+static stream_capture_stats_t capture_stats;
+
+// === Write the buffered chunk (whole sectors, zero-padded tail) ===
+static bool write_chunk(void) {
+    if (chunk_len == 0) {
+        return true;
+    }
+
+    uint32_t sectors = (chunk_len + STREAM_SECTOR_SIZE - 1) / STREAM_SECTOR_SIZE;
+    memset(&chunk[chunk_len], 0, sectors * STREAM_SECTOR_SIZE - chunk_len);
+    if (next_lba + sectors > end_lba) {
+        capture_stats.last_error = SD_BLOCK_DEVICE_ERROR_PARAMETER;
+        return false;
+    }
+
+    uint32_t start_us = time_us_32();
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    // Other card traffic (the text log) ends the session; resume where we stopped
+    if (!capture_sd->ws_active || capture_sd->ws_next_sector != next_lba) {
+        status = sd_write_session_begin(capture_sd, next_lba, (uint32_t)(end_lba - next_lba));
+        capture_stats.sessions++;
+    }
+    if (status == SD_BLOCK_DEVICE_ERROR_NONE) {
+        status = sd_write_session_append(capture_sd, chunk, sectors);
+    }
+    uint32_t elapsed = time_us_32() - start_us;
+    if (status != SD_BLOCK_DEVICE_ERROR_NONE) {
+        capture_stats.last_error = status;
+        printf("ERROR: Capture write failed at sector %lu (error %d)\n",
+               (uint32_t)next_lba, status);
+        return false;
+    }
+
+    capture_stats.writes++;
+    capture_stats.write_time_us += elapsed;
+    if (elapsed > capture_stats.max_write_us) {
+        capture_stats.max_write_us = elapsed;
+    }
+    next_lba += sectors;
+    chunk_len = 0;
+    return true;
+}
+
+// === Create the file and reserve max_bytes of contiguous sectors ===
+bool stream_capture_open(const char *path, uint32_t max_bytes) {
+    if (capture_open || max_bytes == 0) {
+        return false;
+    }
+
+    FRESULT fr = f_open(&capture_file, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (fr != FR_OK) {
+        printf("ERROR: Failed to create capture file (error %d)\n", fr);
+        return false;
+    }
+    fr = f_expand(&capture_file, max_bytes, 1);
+    if (fr == FR_OK) {
+        fr = f_sync(&capture_file);
+    }
+    if (fr != FR_OK) {
+        printf("ERROR: No contiguous space for %lu bytes (error %d)\n", max_bytes, fr);
+        f_close(&capture_file);
+        f_unlink(path);
+        return false;
+    }
+
+    FATFS *fs = capture_file.obj.fs;
+    capture_sd = sd_get_by_num(fs->pdrv);
+    next_lba = fs->database + (LBA_t)(capture_file.obj.sclust - 2) * fs->csize;
+    end_lba = next_lba + max_bytes / STREAM_SECTOR_SIZE;
+    chunk_len = 0;
+
+    // The raw writes bypass disk_write, so drop any cached copy of the run
+    sector_cache_t *cache = disk_get_cache(fs->pdrv);
+    if (cache) {
+        sector_cache_discard(cache, next_lba, end_lba - next_lba);
+    }
+
+    memset(&capture_stats, 0, sizeof(capture_stats));
+    capture_stats.started_ms = to_ms_since_boot(get_absolute_time());
+    capture_open = true;
+    return true;
+}
+
+// === Buffer data; full chunks go straight to the card ===
+bool stream_capture_write(const void *data, size_t len) {
+    if (!capture_open) {
+        return false;
+    }
+
+    const uint8_t *src = data;
+    while (len > 0) {
+        size_t n = STREAM_CHUNK_BYTES - chunk_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&chunk[chunk_len], src, n);
+        chunk_len += n;
+        src += n;
+        len -= n;
+        capture_stats.bytes += n;
+
+        if (chunk_len == STREAM_CHUNK_BYTES && !write_chunk()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// === Write the tail and shrink the file to the captured size ===
+bool stream_capture_close(void) {
+    if (!capture_open) {
+        return false;
+    }
+    capture_open = false;
+
+    bool ok = write_chunk();
+    int status = sd_write_session_end(capture_sd);
+    if (status != SD_BLOCK_DEVICE_ERROR_NONE) {
+        capture_stats.last_error = status;
+        ok = false;
+    }
+    FRESULT fr = f_lseek(&capture_file, capture_stats.bytes);
+    if (fr == FR_OK) {
+        fr = f_truncate(&capture_file);
+    }
+    FRESULT fr_close = f_close(&capture_file);
+    if (fr == FR_OK) {
+        fr = fr_close;
+    }
+    if (fr != FR_OK) {
+        printf("ERROR: Failed to finalize capture file (error %d)\n", fr);
+        ok = false;
+    }
+
+    capture_stats.elapsed_ms = to_ms_since_boot(get_absolute_time()) - capture_stats.started_ms;
+    return ok;
+}
+
+bool stream_capture_active(void) {
+    return capture_open;
+}
+
+void stream_capture_get_stats(stream_capture_stats_t *stats) {
+    *stats = capture_stats;
+}
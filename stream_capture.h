@@ -0,0 +1,46 @@
+/**
+ * @file stream_capture.h
+ * @author Denis Viana
+ * @date 2025
+ * @brief High-rate capture written as raw sectors into a contiguous file
+ *
+ * The capture file is created with f_expand, so its clusters form one
+ * contiguous run of sectors. Data is then written straight to those sectors
+ * through the SD driver, as appends to one open multi-block write session,
+ * without going through f_write. FatFs only touches the file's metadata twice: once at open and once
+ * at close, when the file is truncated to the bytes actually captured.
+ */
+
+#ifndef STREAM_CAPTURE_H
+#define STREAM_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// === Build-time Configuration ===
+// Bytes buffered per multi-block write. Must be a multiple of 512.
+#ifndef STREAM_CHUNK_BYTES
+#define STREAM_CHUNK_BYTES      8192
+#endif
+
+#define STREAM_SECTOR_SIZE      512
+
+typedef struct {
+    uint32_t bytes;         // Bytes accepted by stream_capture_write()
+    uint32_t writes;        // Chunks appended to the write session
+    uint32_t sessions;      // Write sessions opened (1 unless other writes intervened)
+    uint32_t max_write_us;  // Slowest single write
+    uint64_t write_time_us; // Total time spent writing
+    uint32_t started_ms;    // Time of stream_capture_open()
+    uint32_t elapsed_ms;    // Duration of the last completed capture
+    int last_error;         // Last SD driver error (0 if none)
+} stream_capture_stats_t;
+
+bool stream_capture_open(const char *path, uint32_t max_bytes);
+bool stream_capture_write(const void *data, size_t len);
+bool stream_capture_close(void);
+bool stream_capture_active(void);
+void stream_capture_get_stats(stream_capture_stats_t *stats);
+
+#endif // STREAM_CAPTURE_H
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+BitDogLab Datalogger - binary log decoder
+
+Converts a bitdoglab.bin file written with LOG_FORMAT_BINARY=1 back to CSV.
+
+    python3 tools/bdlg_decode.py bitdoglab.bin > bitdoglab.txt
+    python3 tools/bdlg_decode.py --notebook bitdoglab.bin > bitdoglab.csv
+
+The default output matches the firmware CSV (Event,Timestamp_ms,X,Y). With
+--notebook the rows use the Tipo,Valor,Timestamp layout read by pico.ipynb.
+The record layout is documented in log_format.h.
+
+Author: Denis Viana (2025)
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"BDLG"
+SUPPORTED_VERSION = 1
+RECORD = struct.Struct("<iI")
+RECORD_SESSION = 0xFE
+RECORD_TIME = 0xFF
+JOYSTICK_POS = "JOYSTICK_POS"
+
+
+def read_header(data):
+    if data[:4] != MAGIC:
+        raise ValueError("not a BitDogLab binary log (bad magic)")
+    version, header_len, count = struct.unpack_from("<HHB", data, 4)
+    if version != SUPPORTED_VERSION:
+        raise ValueError(f"unsupported log version {version}")
+
+    names = {}
+    pos = 9
+    for _ in range(count):
+        event_id, name_len = data[pos], data[pos + 1]
+        names[event_id] = data[pos + 2:pos + 2 + name_len].decode("ascii")
+        pos += 2 + name_len
+    return names, header_len
+
+
+def decode(data):
+    """Yield (session, name, timestamp_us, value) for every event record."""
+    names, offset = read_header(data)
+    timestamp_us = 0
+    session = 0
+
+    usable = offset + (len(data) - offset) // RECORD.size * RECORD.size
+    for delta, word in RECORD.iter_unpack(data[offset:usable]):
+        record_id = word & 0xFF
+        value = word >> 8
+        if record_id in (RECORD_SESSION, RECORD_TIME):
+            timestamp_us = (value << 32) | (delta & 0xFFFFFFFF)
+            if record_id == RECORD_SESSION:
+                session += 1
+            continue
+        timestamp_us += delta
+        yield session, names.get(record_id, f"UNKNOWN_{record_id}"), timestamp_us, value
+
+
+def format_ms(timestamp_us):
+    return f"{timestamp_us // 1000}.{timestamp_us % 1000:03d}"
+
+
+def write_firmware_csv(records, out):
+    out.write("Event,Timestamp_ms,X,Y\n")
+    for _, name, timestamp_us, value in records:
+        if name == JOYSTICK_POS:
+            out.write(f"{name},{format_ms(timestamp_us)},{value & 0xFFF},{value >> 12}\n")
+        else:
+            out.write(f"{name},{format_ms(timestamp_us)},,\n")
+
+
+def write_notebook_csv(records, out):
+    out.write("Tipo,Valor,Timestamp\n")
+    for _, name, timestamp_us, value in records:
+        if name == JOYSTICK_POS:
+            out.write(f"Joystick_X,{value & 0xFFF},{format_ms(timestamp_us)}\n")
+            out.write(f"Joystick_Y,{value >> 12},{format_ms(timestamp_us)}\n")
+        else:
+            out.write(f"Evento,{name},{format_ms(timestamp_us)}\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a BitDogLab binary log to CSV")
+    parser.add_argument("logfile", help="bitdoglab.bin copied from the SD card")
+    parser.add_argument("--notebook", action="store_true",
+                        help="emit the Tipo,Valor,Timestamp layout used by pico.ipynb")
+    args = parser.parse_args()
+
+    with open(args.logfile, "rb") as f:
+        data = f.read()
+
+    try:
+        records = decode(data)
+        if args.notebook:
+            write_notebook_csv(records, sys.stdout)
+        else:
+            write_firmware_csv(records, sys.stdout)
+    except ValueError as e:
+        sys.exit(f"error: {e}")
+
+
+if __name__ == "__main__":
+    main()
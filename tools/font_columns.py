@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""
+BitDogLab Datalogger - OLED font generator
+
+Reads the row-major fonts in inc/ssd1306_fonts.c and writes the fonts the
+firmware uses in the SSD1306 page layout: one byte per column covering 8 rows,
+bit 0 on top. ssd1306_WriteChar() stores those bytes directly. Run by the
+build; by hand:
+
+    python3 tools/font_columns.py inc/ssd1306_fonts.c ssd1306_fonts_gen.c \\
+        --sources sd_card.c --chars 32-126
+
+Only fonts named in --sources (Font_6x8, ..., outside comments) or listed
+with --fonts are written, and only the characters in --chars. Each glyph is
+ceil(height / 8) bands of `width` bytes, band by band, rows past the font
+height zero. The row tables are not copied: the generated file replaces
+ssd1306_fonts.c in the build. Every font keeps its SSD1306_INCLUDE_FONT_*
+guard.
+
+Author: Denis Viana (2025)
+"""
+
+import argparse
+import re
+import sys
+
+FIRST_CHAR, LAST_CHAR = 32, 126
+NO_GLYPH = 0xFF
+
+ARRAY = re.compile(r"static const (uint16_t|uint8_t)\s+(\w+)\s*\[\]\s*=\s*\{(.*?)\};", re.S)
+FONT = re.compile(r"#ifdef\s+(SSD1306_INCLUDE_FONT_\w+)[^#]*?"
+                  r"const SSD1306_Font_t\s+(\w+)\s*=\s*\{\s*(\d+)\s*,\s*(\d+)\s*,\s*(\w+)\s*,\s*(\w+)", re.S)
+COMMENT = re.compile(r"//[^\n]*|/\*.*?\*/", re.S)
+REFERENCE = re.compile(r"\bFont_\d+x\d+\b")
+
+
+def parse(source):
+    """Return {font name: (guard, width, height, data name, rows, char widths or None)}."""
+    arrays = {name: [int(v, 0) for v in COMMENT.sub("", body).replace(",", " ").split()]
+              for _, name, body in ARRAY.findall(source)}
+    fonts = {}
+    for guard, name, width, height, data, widths in FONT.findall(source):
+        width, height = int(width), int(height)
+        if data not in arrays:
+            raise ValueError(f"{name}: no array {data}")
+        rows = arrays[data]
+        if width > 16 or len(rows) != (LAST_CHAR - FIRST_CHAR + 1) * height:
+            raise ValueError(f"{name}: unsupported layout")
+        fonts[name] = (guard, width, height, data, rows, arrays.get(widths))
+    return fonts
+
+
+def parse_chars(spec):
+    """"32-126" or "32,48-57" -> sorted character codes."""
+    chars = set()
+    for part in spec.split(","):
+        lo, _, hi = part.strip().partition("-")
+        lo, hi = int(lo, 0), int(hi or lo, 0)
+        if not FIRST_CHAR <= lo <= hi <= LAST_CHAR:
+            raise ValueError(f"character range {part!r} outside {FIRST_CHAR}-{LAST_CHAR}")
+        chars.update(range(lo, hi + 1))
+    return sorted(chars)
+
+
+def transpose(rows, width, height):
+    """Glyph rows (bit 15 = left column) -> page columns, band by band."""
+    out = []
+    for band in range((height + 7) // 8):
+        for x in range(width):
+            byte = 0
+            for bit in range(8):
+                y = band * 8 + bit
+                if y < height and rows[y] & (0x8000 >> x):
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def c_array(ctype, name, values, per_line, labels=None):
+    lines = [f"static const {ctype} {name}[] = {{"]
+    for i in range(0, len(values), per_line):
+        line = "    " + ", ".join(f"0x{v:02X}" for v in values[i:i + per_line]) + ","
+        if labels:
+            line += f"  // {labels[i // per_line]!r}"
+        lines.append(line)
+    lines.append("};")
+    return lines
+
+
+def emit(fonts, selected, chars):
+    """Return (C source, [(font, glyphs, bytes, bytes as row tables)])."""
+    lines = ["// Generated by tools/font_columns.py from inc/ssd1306_fonts.c. Do not edit.",
+             "",
+             '#include "inc/ssd1306_fonts.h"',
+             ""]
+    sizes = []
+    subset = len(chars) != LAST_CHAR - FIRST_CHAR + 1
+    for name in selected:
+        guard, width, height, data, rows, widths = fonts[name]
+        columns = []
+        for ch in chars:
+            glyph = ch - FIRST_CHAR
+            columns += transpose(rows[glyph * height:(glyph + 1) * height], width, height)
+        per_glyph = (height + 7) // 8 * width
+
+        lines.append(f"#ifdef {guard}")
+        lines += c_array("uint8_t", f"{data}_columns", columns, per_glyph, [chr(c) for c in chars])
+        size = len(columns)
+        glyph_map = "NULL"
+        if subset:
+            index = [NO_GLYPH] * (LAST_CHAR - FIRST_CHAR + 1)
+            for i, ch in enumerate(chars):
+                index[ch - FIRST_CHAR] = i
+            lines += c_array("uint8_t", f"{data}_glyphs", index, 16)
+            glyph_map = f"{data}_glyphs"
+            size += len(index)
+        char_width = "NULL"
+        if widths:
+            lines += c_array("uint8_t", f"{data}_widths", widths, 16)
+            char_width = f"{data}_widths"
+            size += len(widths)
+        lines.append(f"const SSD1306_Font_t {name} = "
+                     f"{{{width}, {height}, NULL, {char_width}, {data}_columns, {glyph_map}}};")
+        lines.append("#endif")
+        lines.append("")
+        sizes.append((name, len(chars), size, len(rows) * 2 + (len(widths) if widths else 0)))
+    return "\n".join(lines), sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("font_source", help="ssd1306_fonts.c")
+    parser.add_argument("output", help="generated C file")
+    parser.add_argument("--sources", nargs="*", default=[],
+                        help="firmware sources; fonts they name are generated")
+    parser.add_argument("--fonts", default="",
+                        help="comma-separated fonts to generate as well (e.g. Font_11x18)")
+    parser.add_argument("--chars", default=f"{FIRST_CHAR}-{LAST_CHAR}",
+                        help="character codes to keep, e.g. 32-126 or 32,48-58")
+    args = parser.parse_args()
+
+    with open(args.font_source, encoding="utf-8") as f:
+        fonts = parse(f.read())
+
+    wanted = {name.strip() for name in args.fonts.split(",") if name.strip()}
+    for path in args.sources:
+        with open(path, encoding="utf-8") as f:
+            # Commented-out code does not pull a font in
+            wanted.update(REFERENCE.findall(COMMENT.sub("", f.read())))
+    unknown = wanted - fonts.keys()
+    if unknown:
+        sys.exit(f"unknown font(s): {', '.join(sorted(unknown))}")
+    selected = [name for name in fonts if name in wanted]
+
+    source, sizes = emit(fonts, selected, parse_chars(args.chars))
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(source)
+    for name, glyphs, size, rows in sizes:
+        print(f"{name}: {glyphs} glyphs, {size} bytes (row tables: {rows})")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,169 @@
+/**
+ * @file glyph_check.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Host check and benchmark of the OLED glyph blitter
+ *
+ * Draws every character of every font with ssd1306_WriteChar() twice over the
+ * same random frame: once with the page-column fonts written by
+ * tools/font_columns.py, once with the row tables of inc/ssd1306_fonts.c,
+ * which take the pixel-by-pixel path. The frames and return values must be
+ * identical at every row and in both colors. Characters left out of a subset
+ * (--chars) must return 0 and leave the frame untouched. Then both paths are
+ * timed in glyphs per second, on a page-aligned row and on an unaligned one.
+ *
+ *     python3 tools/font_columns.py inc/ssd1306_fonts.c /tmp/fonts_gen.c \
+ *         --fonts Font_6x8,Font_7x10,Font_11x18,Font_16x26,Font_16x24,Font_16x15
+ *     cc -O2 -Itools/sdk_stubs -I. tools/glyph_check.c /tmp/fonts_gen.c \
+ *         -lm -o /tmp/glyph_check && /tmp/glyph_check
+ *
+ * Add e.g. --chars 32,48-58 to the first command to check a subset. The
+ * SDK headers come from tools/sdk_stubs; the driver is compiled from
+ * inc/ssd1306.c unchanged, and no transfer to the panel ever starts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "inc/ssd1306.c"
+#include "inc/ssd1306_fonts.h"
+
+// The row tables, renamed so they sit next to the generated fonts
+#define Font_6x8 Rows_6x8
+#define Font_7x10 Rows_7x10
+#define Font_11x18 Rows_11x18
+#define Font_16x26 Rows_16x26
+#define Font_16x24 Rows_16x24
+#define Font_16x15 Rows_16x15
+#include "inc/ssd1306_fonts.c"
+#undef Font_6x8
+#undef Font_7x10
+#undef Font_11x18
+#undef Font_16x26
+#undef Font_16x24
+#undef Font_16x15
+
+#define BENCH_SECONDS 0.3
+
+typedef struct {
+    const char *name;
+    const SSD1306_Font_t *columns;      // Generated by tools/font_columns.py
+    const SSD1306_Font_t *rows;         // Row table: pixel-by-pixel path
+} font_pair_t;
+
+static const font_pair_t fonts[] = {
+#ifdef SSD1306_INCLUDE_FONT_6x8
+    {"6x8", &Font_6x8, &Rows_6x8},
+#endif
+#ifdef SSD1306_INCLUDE_FONT_7x10
+    {"7x10", &Font_7x10, &Rows_7x10},
+#endif
+#ifdef SSD1306_INCLUDE_FONT_11x18
+    {"11x18", &Font_11x18, &Rows_11x18},
+#endif
+#ifdef SSD1306_INCLUDE_FONT_16x26
+    {"16x26", &Font_16x26, &Rows_16x26},
+#endif
+#ifdef SSD1306_INCLUDE_FONT_16x24
+    {"16x24", &Font_16x24, &Rows_16x24},
+#endif
+#ifdef SSD1306_INCLUDE_FONT_16x15
+    {"16x15", &Font_16x15, &Rows_16x15},
+#endif
+};
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool in_subset(const SSD1306_Font_t *font, char ch) {
+    return font->glyph_map == NULL || font->glyph_map[ch - 32] != 0xFF;
+}
+
+// === Byte-for-byte comparison with the pixel path ===
+static long check(const font_pair_t *pair, long *failures) {
+    static uint8_t background[SSD1306_BUFFER_SIZE], expected[SSD1306_BUFFER_SIZE];
+    const SSD1306_Font_t *font = pair->columns;
+    long cases = 0;
+
+    if (font->columns == NULL || pair->rows->columns != NULL) {
+        printf("FAIL: %s: expected a generated font and a row-table font\n", pair->name);
+        (*failures)++;
+        return 0;
+    }
+
+    for (int ch = 32; ch < 127; ch++) {
+        for (int y = 0; y + font->height <= SSD1306_HEIGHT; y++) {
+            for (int color = Black; color <= White; color++) {
+                int x = rand() % (SSD1306_WIDTH - font->width + 1);
+                for (size_t i = 0; i < sizeof background; i++) {
+                    background[i] = (uint8_t)rand();
+                }
+
+                memcpy(SSD1306_Buffer, background, sizeof background);
+                ssd1306_SetCursor(x, y);
+                char drawn_rows = ssd1306_WriteChar(ch, *pair->rows, color);
+                memcpy(expected, SSD1306_Buffer, sizeof expected);
+
+                memcpy(SSD1306_Buffer, background, sizeof background);
+                ssd1306_SetCursor(x, y);
+                char drawn = ssd1306_WriteChar(ch, *font, color);
+
+                bool ok;
+                if (in_subset(font, ch)) {
+                    ok = drawn == drawn_rows && memcmp(SSD1306_Buffer, expected, sizeof expected) == 0;
+                } else {
+                    ok = drawn == 0 && memcmp(SSD1306_Buffer, background, sizeof background) == 0;
+                }
+                if (!ok && (*failures)++ < 10) {
+                    printf("FAIL: %s '%c' at x %d y %d color %d\n", pair->name, ch, x, y, color);
+                }
+                cases++;
+            }
+        }
+    }
+    return cases;
+}
+
+// === Glyphs per second along one text row ===
+static double glyph_rate(const SSD1306_Font_t *font, uint8_t y) {
+    long glyphs = 0;
+    double start = now_s();
+    double elapsed;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            ssd1306_SetCursor((i * font->width) % (SSD1306_WIDTH - font->width + 1), y);
+            char ch = '!' + i % 94;
+            if (in_subset(font, ch)) {
+                glyphs += ssd1306_WriteChar(ch, *font, White) != 0;
+            }
+        }
+        elapsed = now_s() - start;
+    } while (elapsed < BENCH_SECONDS);
+    return glyphs / elapsed;
+}
+
+int main(void) {
+    long failures = 0, cases = 0;
+    srand(2025);
+    for (size_t f = 0; f < count_of(fonts); f++) {
+        cases += check(&fonts[f], &failures);
+    }
+    printf("%ld glyph draws compared with the pixel path: %s\n", cases, failures ? "MISMATCH" : "identical");
+
+    printf("font    pixel y=8    blit y=8     pixel y=3    blit y=3   (glyphs/s)\n");
+    for (size_t f = 0; f < count_of(fonts); f++) {
+        const font_pair_t *pair = &fonts[f];
+        if (pair->rows->height > SSD1306_HEIGHT - 8) {
+            continue;
+        }
+        printf("%-6s %11.0f  %11.0f  %11.0f  %11.0f\n", pair->name,
+               glyph_rate(pair->rows, 8), glyph_rate(pair->columns, 8),
+               glyph_rate(pair->rows, 3), glyph_rate(pair->columns, 3));
+    }
+    return failures ? 1 : 0;
+}
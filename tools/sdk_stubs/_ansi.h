@@ -0,0 +1,8 @@
+// Host stub: newlib's C/C++ linkage markers
+#ifndef _ANSIDECL_H_
+#define _ANSIDECL_H_
+
+#define _BEGIN_STD_C
+#define _END_STD_C
+
+#endif
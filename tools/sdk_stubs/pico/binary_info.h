@@ -0,0 +1 @@
+// Host stub of the Pico SDK: binary info is not used on the host
@@ -0,0 +1,20 @@
+// Host stub of the Pico SDK: only what inc/ssd1306.c uses
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+static inline void sleep_ms(uint32_t ms) { (void)ms; }
+static inline void tight_loop_contents(void) {}
+static inline void gpio_set_function(uint gpio, int fn) { (void)gpio; (void)fn; }
+static inline void gpio_pull_up(uint gpio) { (void)gpio; }
+
+#define GPIO_FUNC_I2C 3
+
+#endif
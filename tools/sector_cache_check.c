@@ -0,0 +1,213 @@
+/**
+ * @file sector_cache_check.c
+ * @author Denis Viana
+ * @date 2025
+ * @brief Host test of the sector cache against a disk image
+ *
+ * Drives sector_cache_read/write/flush/discard with random operations over a
+ * file-backed image and compares every read with a plain copy of what the
+ * disk should hold. After each flush the image itself must match that copy.
+ * Some flushes are made to fail, after which the data must still be cached
+ * and written by the next flush. Writes behind the cache's back followed by
+ * sector_cache_discard() stand in for the raw-sector capture.
+ *
+ *     cc -O2 -Ilib/FatFs_SPI/include tools/sector_cache_check.c \
+ *         lib/FatFs_SPI/src/sector_cache.c -o /tmp/sector_cache_check
+ *     /tmp/sector_cache_check [image] [operations] [seed]
+ *
+ * Without an image path a temporary file is used. Add -DSECTOR_CACHE_SECTORS=
+ * or -DSECTOR_CACHE_BYPASS= to both sources to try other configurations.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sector_cache.h"
+
+#define SS SECTOR_CACHE_SECTOR_SIZE
+#define IMAGE_SECTORS 96        // Several times the cache, so it evicts
+#define MAX_TRANSFER 12         // Sectors per random transfer
+#define DEVICE_ERROR 0x55
+
+// === File-backed block device ===
+typedef struct {
+    FILE *file;
+    bool fail_next_write;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t failed;
+} image_t;
+
+static int image_read(void *ctx, uint8_t *buffer, uint64_t sector, uint32_t count) {
+    image_t *img = ctx;
+    if (sector + count > IMAGE_SECTORS) {
+        printf("FAIL: backend read past the image (%llu+%lu)\n",
+               (unsigned long long)sector, (unsigned long)count);
+        exit(1);
+    }
+    img->reads++;
+    if (fseek(img->file, (long)(sector * SS), SEEK_SET) != 0 ||
+        fread(buffer, SS, count, img->file) != count) {
+        return DEVICE_ERROR;
+    }
+    return 0;
+}
+
+static int image_write(void *ctx, const uint8_t *buffer, uint64_t sector, uint32_t count) {
+    image_t *img = ctx;
+    if (sector + count > IMAGE_SECTORS) {
+        printf("FAIL: backend write past the image (%llu+%lu)\n",
+               (unsigned long long)sector, (unsigned long)count);
+        exit(1);
+    }
+    if (img->fail_next_write) {
+        img->fail_next_write = false;
+        img->failed++;
+        return DEVICE_ERROR;
+    }
+    img->writes++;
+    if (fseek(img->file, (long)(sector * SS), SEEK_SET) != 0 ||
+        fwrite(buffer, SS, count, img->file) != count) {
+        return DEVICE_ERROR;
+    }
+    return 0;
+}
+
+// === Test state ===
+static image_t image;
+static sector_cache_t cache;
+static uint8_t expected[IMAGE_SECTORS][SS];     // What the disk should hold
+static uint8_t buffer[MAX_TRANSFER * SS];
+static unsigned long failures;
+
+static void fail(const char *what, unsigned long op, uint64_t sector) {
+    if (failures++ < 10) {
+        printf("FAIL: operation %lu: %s at sector %llu\n", op, what, (unsigned long long)sector);
+    }
+}
+
+static void fill_random(uint8_t *dst, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (uint8_t)rand();
+    }
+}
+
+static void random_range(uint64_t *sector, uint32_t *count) {
+    *count = 1 + rand() % MAX_TRANSFER;
+    // Mostly single sectors, as FatFs issues them for FAT and directory data
+    if (rand() % 2) {
+        *count = 1;
+    }
+    *sector = rand() % (IMAGE_SECTORS - *count + 1);
+}
+
+static void check_image(unsigned long op) {
+    static uint8_t sector_data[SS];
+    for (uint64_t s = 0; s < IMAGE_SECTORS; s++) {
+        if (fseek(image.file, (long)(s * SS), SEEK_SET) != 0 ||
+            fread(sector_data, SS, 1, image.file) != 1 ||
+            memcmp(sector_data, expected[s], SS) != 0) {
+            fail("image differs after flush", op, s);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : NULL;
+    unsigned long operations = argc > 2 ? strtoul(argv[2], NULL, 0) : 200000;
+    unsigned seed = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 0) : 2025;
+
+    image.file = path ? fopen(path, "w+b") : tmpfile();
+    if (!image.file) {
+        perror(path ? path : "tmpfile");
+        return 2;
+    }
+    srand(seed);
+    fill_random(&expected[0][0], sizeof expected);
+    if (fwrite(expected, SS, IMAGE_SECTORS, image.file) != IMAGE_SECTORS) {
+        perror("image");
+        return 2;
+    }
+
+    sector_cache_backend_t backend = {image_read, image_write, &image};
+    sector_cache_init(&cache, &backend);
+
+    unsigned long reads = 0, writes = 0, flushes = 0, discards = 0;
+    for (unsigned long op = 0; op < operations; op++) {
+        uint64_t sector;
+        uint32_t count;
+        int kind = rand() % 100;
+
+        if (kind < 45) {
+            random_range(&sector, &count);
+            if (sector_cache_read(&cache, buffer, sector, count) != 0) {
+                fail("read error", op, sector);
+            }
+            for (uint32_t k = 0; k < count; k++) {
+                if (memcmp(&buffer[k * SS], expected[sector + k], SS) != 0) {
+                    fail("read data differs", op, sector + k);
+                }
+            }
+            reads++;
+        } else if (kind < 90) {
+            random_range(&sector, &count);
+            fill_random(buffer, count * SS);
+            if (sector_cache_write(&cache, buffer, sector, count) != 0) {
+                fail("write error", op, sector);
+            }
+            memcpy(expected[sector], buffer, count * SS);
+            writes++;
+        } else if (kind < 97) {
+            // One flush in four fails on its first backend write
+            bool inject = rand() % 4 == 0;
+            image.fail_next_write = inject;
+            int status = sector_cache_flush(&cache);
+            if (image.fail_next_write) {
+                // Nothing was dirty: the failure was not consumed
+                image.fail_next_write = false;
+            } else if (inject) {
+                if (status != DEVICE_ERROR) {
+                    fail("flush did not report the device error", op, 0);
+                }
+                status = sector_cache_flush(&cache);
+            }
+            if (status != 0) {
+                fail("flush error", op, 0);
+            }
+            check_image(op);
+            flushes++;
+        } else {
+            // Sectors rewritten behind the cache, as the raw capture does
+            random_range(&sector, &count);
+            fill_random(buffer, count * SS);
+            if (image_write(&image, buffer, sector, count) != 0) {
+                fail("image write error", op, sector);
+            }
+            sector_cache_discard(&cache, sector, count);
+            memcpy(expected[sector], buffer, count * SS);
+            discards++;
+        }
+    }
+
+    if (sector_cache_flush(&cache) != 0) {
+        fail("final flush error", operations, 0);
+    }
+    check_image(operations);
+
+    sector_cache_stats_t stats;
+    sector_cache_get_stats(&cache, &stats);
+    printf("%lu operations (%lu reads, %lu writes, %lu flushes, %lu discards), seed %u\n",
+           operations, reads, writes, flushes, discards, seed);
+    printf("cache: %lu hits, %lu misses, %lu evictions, %lu write-backs of %lu sectors, %lu bypassed\n",
+           (unsigned long)stats.hits, (unsigned long)stats.misses, (unsigned long)stats.evictions,
+           (unsigned long)stats.writebacks, (unsigned long)stats.written_back,
+           (unsigned long)stats.bypassed);
+    printf("device: %lu reads, %lu writes, %lu injected failures\n",
+           (unsigned long)image.reads, (unsigned long)image.writes, (unsigned long)image.failed);
+    printf("%s\n", failures ? "MISMATCH" : "identical");
+
+    fclose(image.file);
+    return failures ? 1 : 0;
+}